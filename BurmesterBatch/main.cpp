@@ -0,0 +1,301 @@
+#include <kinematics/PoseFile.h>
+#include <kinematics/BurmesterSolver.h>
+#include <kinematics/SolutionCache.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+/**
+ * Headless batch synthesis of four-bar linkages.
+ * Each pose file is solved through the whole pipeline, i.e., the poles, the solution curves, the special points,
+ * the extreme poses, and the search of the valid solutions, by a pool of worker threads, and the result of each file is
+ * written as one JSON line as soon as it is finished. Thus, the lines are in the order of completion, and "index" is
+ * the position of the file in the input.
+ *
+ * Usage: BurmesterBatch <directory or manifest> [-o <output.jsonl>] [-j <number of threads>] [-n <max solutions>] [-c <cache directory>]
+ *
+ * If the input is a directory, all the *.xml files in it are solved. Otherwise, the input is a manifest that lists
+ * a pose file in each line, relative to the manifest. Empty lines and lines that begin with '#' are ignored.
+ */
+
+class BatchParams {
+public:
+	std::string input;
+	std::string output;
+	int num_threads;
+	int max_solutions;
+	std::string cache_directory;
+
+public:
+	BatchParams() : num_threads(0), max_solutions(1) {}
+};
+
+void printUsage() {
+	std::cerr << "Usage: BurmesterBatch <directory or manifest> [-o <output.jsonl>] [-j <number of threads>] [-n <max solutions>] [-c <cache directory>]" << std::endl;
+}
+
+bool parseArguments(int argc, char* argv[], BatchParams& params) {
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "-o" || arg == "-j" || arg == "-n" || arg == "-c") {
+			if (i + 1 >= argc) return false;
+			std::string value = argv[++i];
+			if (arg == "-o") params.output = value;
+			else if (arg == "-j") params.num_threads = atoi(value.c_str());
+			else if (arg == "-n") params.max_solutions = atoi(value.c_str());
+			else params.cache_directory = value;
+		}
+		else if (arg[0] == '-' || !params.input.empty()) {
+			return false;
+		}
+		else {
+			params.input = arg;
+		}
+	}
+
+	return !params.input.empty() && params.num_threads >= 0 && params.max_solutions >= 0;
+}
+
+bool isDirectory(const std::string& path) {
+#ifdef _WIN32
+	DWORD attributes = GetFileAttributesA(path.c_str());
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#else
+	struct stat st;
+	return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+#endif
+}
+
+bool isAbsolutePath(const std::string& path) {
+	if (path.empty()) return false;
+	if (path[0] == '/' || path[0] == '\\') return true;
+	return path.size() >= 2 && isalpha((unsigned char)path[0]) && path[1] == ':';
+}
+
+/**
+ * List the names of the files in the directory whose names end with the extension, in the order of the names.
+ */
+bool listFiles(const std::string& directory, const std::string& extension, std::vector<std::string>& names) {
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE handle = FindFirstFileA((directory + "\\*" + extension).c_str(), &data);
+	if (handle == INVALID_HANDLE_VALUE) return GetLastError() == ERROR_FILE_NOT_FOUND;
+	do {
+		if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) names.push_back(data.cFileName);
+	} while (FindNextFileA(handle, &data));
+	FindClose(handle);
+#else
+	DIR* dir = opendir(directory.c_str());
+	if (dir == NULL) return false;
+	while (struct dirent* entry = readdir(dir)) {
+		std::string name = entry->d_name;
+		if (name.size() <= extension.size() || name.compare(name.size() - extension.size(), extension.size(), extension) != 0) continue;
+		if (!isDirectory(directory + "/" + name)) names.push_back(name);
+	}
+	closedir(dir);
+#endif
+
+	std::sort(names.begin(), names.end());
+	return true;
+}
+
+/**
+ * List the pose files in the directory, or the pose files in the manifest.
+ */
+bool listPoseFiles(const std::string& input, std::vector<std::string>& filenames) {
+	if (isDirectory(input)) {
+		std::vector<std::string> names;
+		if (!listFiles(input, ".xml", names)) return false;
+		for (int i = 0; i < names.size(); i++) {
+			filenames.push_back(input + "/" + names[i]);
+		}
+		return true;
+	}
+
+	std::ifstream file(input);
+	if (!file) return false;
+
+	// the relative paths in the manifest are relative to the directory of the manifest
+	size_t separator = input.find_last_of("/\\");
+	std::string dir = separator == std::string::npos ? "" : input.substr(0, separator + 1);
+
+	std::string line;
+	while (std::getline(file, line)) {
+		size_t first = line.find_first_not_of(" \t\r\n");
+		if (first == std::string::npos || line[first] == '#') continue;
+		line = line.substr(first, line.find_last_not_of(" \t\r\n") - first + 1);
+		filenames.push_back(isAbsolutePath(line) ? line : dir + line);
+	}
+	return true;
+}
+
+std::string toJson(const std::string& str) {
+	std::ostringstream out;
+	out << "\"";
+	for (int i = 0; i < str.size(); i++) {
+		unsigned char c = str[i];
+		if (c == '"' || c == '\\') out << "\\" << c;
+		else if (c == '\n') out << "\\n";
+		else if (c == '\r') out << "\\r";
+		else if (c == '\t') out << "\\t";
+		else if (c < 0x20) out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec;
+		else out << c;
+	}
+	out << "\"";
+	return out.str();
+}
+
+std::string toJson(const glm::dvec2& p) {
+	std::ostringstream out;
+	out << std::setprecision(17) << "[" << p.x << "," << p.y << "]";
+	return out.str();
+}
+
+std::string toJson(const kinematics::SolutionCandidate& candidate) {
+	std::ostringstream out;
+	out << std::setprecision(17);
+	out << "{\"length\":" << candidate.length << ",\"order\":" << candidate.order;
+	out << ",\"C1\":" << toJson(candidate.C1) << ",\"C2\":" << toJson(candidate.C2);
+	out << ",\"X1\":" << toJson(candidate.X1) << ",\"X2\":" << toJson(candidate.X2);
+	out << ",\"grashof_type\":" << candidate.grashof_type;
+	out << ",\"grashof_defect\":" << (candidate.grashof_defect ? "true" : "false");
+	out << ",\"order_defect\":" << (candidate.order_defect ? "true" : "false");
+	out << ",\"branch_defect\":" << (candidate.branch_defect ? "true" : "false") << "}";
+	return out.str();
+}
+
+/**
+ * Solve one pose file, and make its result as a JSON line without the line break.
+ * The search of each file runs in the calling thread, since the files are already solved in parallel.
+ * If the file cannot be solved, false is returned, and the line has the error message.
+ */
+bool solve(int index, const std::string& filename, const BatchParams& params, kinematics::SolutionCache& cache, std::string& line) {
+	std::ostringstream out;
+	out << "{\"index\":" << index << ",\"file\":" << toJson(filename);
+
+	auto start = std::chrono::steady_clock::now();
+	try {
+		std::vector<glm::dmat4x4> poses;
+		kinematics::readPoseFile(filename, poses);
+
+		kinematics::CurveSamplingParams sampling_params;
+		kinematics::SolutionSearchParams search_params(params.max_solutions, false, 1);
+		std::string key = kinematics::SolutionCache::makeKey(poses, sampling_params, search_params);
+
+		kinematics::SolutionCacheEntry entry;
+		bool cached = cache.find(key, entry) && entry.solved;
+		if (!cached) {
+			kinematics::BurmesterSolver solver(poses, sampling_params);
+			entry.solutions = solver.getSolutions();
+			entry.pole_intersections = solver.getPoleIntersections();
+			entry.UTs = solver.getUTs();
+			entry.extreme_poses = solver.getExtremePoses();
+			bool completed;
+			entry.candidates = solver.findValidSolutions(search_params, completed);
+			entry.solved = completed;
+			cache.insert(key, entry);
+		}
+
+		double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		out << ",\"status\":\"ok\",\"cached\":" << (cached ? "true" : "false") << ",\"time_ms\":" << std::fixed << std::setprecision(3) << time;
+		out << ",\"num_loops\":" << (entry.solutions.size() > 0 ? entry.solutions[0].numLoops() : 0);
+		out << ",\"num_points\":" << (entry.solutions.size() > 0 ? entry.solutions[0].numPoints() : 0);
+		out << ",\"solutions\":[";
+		for (int i = 0; i < entry.candidates.size(); i++) {
+			if (i > 0) out << ",";
+			out << toJson(entry.candidates[i]);
+		}
+		out << "]}";
+	}
+	catch (char* ex) {
+		out << ",\"status\":\"error\",\"error\":" << toJson(ex) << "}";
+		line = out.str();
+		return false;
+	}
+	catch (const std::exception& ex) {
+		out << ",\"status\":\"error\",\"error\":" << toJson(ex.what()) << "}";
+		line = out.str();
+		return false;
+	}
+
+	line = out.str();
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	BatchParams params;
+	if (!parseArguments(argc, argv, params)) {
+		printUsage();
+		return 1;
+	}
+
+	std::vector<std::string> filenames;
+	if (!listPoseFiles(params.input, filenames)) {
+		std::cerr << "Input cannot open: " << params.input << std::endl;
+		return 1;
+	}
+
+	std::ofstream file;
+	if (!params.output.empty()) {
+		file.open(params.output, std::ios::trunc);
+		if (!file) {
+			std::cerr << "Output cannot open: " << params.output << std::endl;
+			return 1;
+		}
+	}
+	std::ostream& out = params.output.empty() ? std::cout : file;
+
+	// with the on-disk cache, a batch that is run again skips the pose files that have been solved
+	kinematics::SolutionCache cache(16, params.cache_directory);
+
+	int num_threads = params.num_threads > 0 ? params.num_threads : std::max(1, (int)std::thread::hardware_concurrency());
+	num_threads = std::min(num_threads, std::max(1, (int)filenames.size()));
+
+	std::atomic<int> next(0);
+	std::atomic<int> num_errors(0);
+	std::mutex out_mutex;
+	auto worker = [&]() {
+		while (true) {
+			int index = next++;
+			if (index >= filenames.size()) break;
+
+			std::string line;
+			if (!solve(index, filenames[index], params, cache, line)) num_errors++;
+
+			// flush each line so that the results of a long batch can be read while it is running
+			std::lock_guard<std::mutex> lock(out_mutex);
+			out << line << std::endl;
+		}
+	};
+
+	if (num_threads == 1) {
+		worker();
+	}
+	else {
+		std::vector<std::thread> threads;
+		for (int i = 0; i < num_threads; i++) {
+			threads.push_back(std::thread(worker));
+		}
+		for (int i = 0; i < threads.size(); i++) {
+			threads[i].join();
+		}
+	}
+
+	std::cerr << filenames.size() << " pose files processed, " << num_errors << " errors." << std::endl;
+	return num_errors > 0 ? 2 : 0;
+}
\ No newline at end of file
@@ -23,9 +23,14 @@ Canvas::Canvas(QWidget *parent) : QWidget(parent) {
 	grashofDefect = false;
 	orderDefect = false;
 	branchDefect = false;
+	crank_range = -1;
 
 	showCenterPointCurve = false;
 	showCirclePointCurve = true;
+
+	search_cancelled = false;
+	search_running = false;
+	search_progress = 0;
 	
 	// read solution curve
 	/*
@@ -86,45 +91,14 @@ Canvas::Canvas(QWidget *parent) : QWidget(parent) {
 }
 
 Canvas::~Canvas() {
+	cancelSolutionSearch();
 }
 
 void Canvas::open(const QString& filename) {
-	QFile file(filename);
-	if(!file.open(QFile::ReadOnly | QFile::Text)) throw "File cannot open.";
-
-	QDomDocument doc;
-	doc.setContent(&file);
-	QDomElement root = doc.documentElement();
-	if (root.tagName() != "poses")	throw "Invalid file format.";
-
-	poses.clear();
-
-	QDomNode node = root.firstChild();
-	while (!node.isNull()) {
-		if (node.toElement().tagName() == "pose") {
-			std::vector<glm::dvec2> pts;
-			QDomNode point_node = node.firstChild();
-			while (!point_node.isNull()) {
-				if (point_node.toElement().tagName() == "point") {
-					double x = point_node.toElement().attribute("x").toDouble();
-					double y = point_node.toElement().attribute("y").toDouble();
-					pts.push_back(glm::dvec2(x, y));
-				}
-				point_node = point_node.nextSibling();
-			}
+	// stop searching the solution for the previous poses
+	cancelSolutionSearch();
 
-			if (pts.size() == 2) {
-				double theta = atan2(pts[1].y - pts[0].y, pts[1].x - pts[0].x);
-				poses.push_back({ cos(theta), sin(theta), 0, 0, -sin(theta), cos(theta), 0, 0, 0, 0, 1, 0, pts[0].x, pts[0].y, 0, 1 });
-			}
-		}
-
-		node = node.nextSibling();
-	}
-
-	if (poses.size() != 4) {
-		throw "Invalid number of poses was specified.";
-	}
+	kinematics::readPoseFile(filename, poses);
 
 	// body geometry
 	body_pts.clear();
@@ -136,28 +110,153 @@ void Canvas::open(const QString& filename) {
 		body_pts[i].push_back(glm::dvec2(poses[i] * glm::dvec4(0, 0.25, 0, 1)));
 	}
 
+	// sweep the curves over all the hardware threads, which gives the same curves as the serial sweep
+	kinematics::CurveSamplingParams sampling_params;
+	sampling_params.num_threads = 0;
+
+	// reuse the curves and the solution of the same poses if they have been solved before
+	search_cache_key = kinematics::SolutionCache::makeKey(poses, sampling_params, kinematics::SolutionSearchParams(1));
+	kinematics::SolutionCacheEntry entry;
+	bool cached = solution_cache.find(search_cache_key, entry);
+
 	// calculate the circle point curve and center point curve
-	kinematics::calculateSolutionCurve(poses, solutions);
+	if (cached) {
+		solutions = entry.solutions;
+	}
+	else {
+		kinematics::calculateSolutionCurve(poses, solutions, sampling_params);
+	}
+	solution_indices.resize(solutions.size());
+	for (int i = 0; i < solutions.size(); i++) {
+		solution_indices[i].build(solutions[i]);
+	}
 
 	poles = kinematics::calculatePoles(poses);
-	pole_intersections = kinematics::calculatePoleIntersections(poses, solutions);
+	if (cached) {
+		pole_intersections = entry.pole_intersections;
+		UTs = entry.UTs;
+		extreme_poses = entry.extreme_poses;
+	}
+	else {
+		pole_intersections = kinematics::calculatePoleIntersections(poses, solutions, solution_indices);
+		UTs = kinematics::calculateUTs(solutions[1], poles);
+		extreme_poses = kinematics::findExtremePoses(poses, solutions[1], poles[1], pole_intersections[1], UTs);
+
+		entry.solutions = solutions;
+		entry.pole_intersections = pole_intersections;
+		entry.UTs = UTs;
+		entry.extreme_poses = extreme_poses;
+		solution_cache.insert(search_cache_key, entry);
+	}
+	extreme_pose_index.build(solutions[1], extreme_poses);
 
-	UTs = kinematics::calculateUTs(solutions[1], poles);
 	Bs.clear();
-	for (int i = 0; i < solutions[1].size(); i++) {
-		Bs.push_back(solutions[1][i][0]);
+	for (int i = 0; i < solutions[1].numLoops(); i++) {
+		Bs.push_back(solutions[1].front(i));
 	}
 
-	extreme_poses = kinematics::findExtremePoses(poses, solutions[1], poles[1], pole_intersections[1], UTs);
+	if (entry.solved) {
+		// apply the cached solution
+		{
+			std::lock_guard<std::mutex> lock(search_mutex);
+			search_best = entry.candidates.size() > 0 ? entry.candidates[0] : kinematics::SolutionCandidate();
+		}
+		search_cancelled = false;
+		solution_update();
+	}
+	else {
+		// find the best solution in the background so that the window stays responsive
+		startSolutionSearch();
+	}
+
+	update();
+}
+
+/**
+ * Start searching the best solution in a background thread.
+ * The best solution found so far is applied by solution_update() whenever it is improved.
+ */
+void Canvas::startSolutionSearch() {
+	cancelSolutionSearch();
+
+	{
+		std::lock_guard<std::mutex> lock(search_mutex);
+		search_best = kinematics::SolutionCandidate();
+	}
+	search_cancelled = false;
+	search_running = true;
+	search_progress = 0;
+
+	std::vector<glm::dmat4x4> poses = this->poses;
+	std::vector<kinematics::CurveSet> solutions = this->solutions;
+	std::string cache_key = search_cache_key;
+	search_thread = std::thread([this, poses, solutions, cache_key]() {
+		kinematics::SolutionSearchParams params(1);
+		params.cancelled = &search_cancelled;
+		params.callback = [this](const kinematics::SolutionCandidate& candidate) {
+			std::lock_guard<std::mutex> lock(search_mutex);
+			if (candidate.isBetterThan(search_best)) {
+				search_best = candidate;
+				QMetaObject::invokeMethod(this, "solution_update", Qt::QueuedConnection);
+			}
+		};
+		params.progress = [this](long long num_examined, long long num_pairs) {
+			int progress = num_examined * 100 / std::max(1LL, num_pairs);
+			if (progress != search_progress) {
+				search_progress = progress;
+				QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+			}
+		};
 
+		bool completed;
+		std::vector<kinematics::SolutionCandidate> candidates = kinematics::findValidSolutions(kinematics::PoseSet<4>(poses), solutions, params, completed);
 
+		// store the result of the completed search so that the same poses are not solved again
+		kinematics::SolutionCacheEntry entry;
+		if (completed && solution_cache.find(cache_key, entry)) {
+			entry.solved = true;
+			entry.candidates = candidates;
+			solution_cache.insert(cache_key, entry);
+		}
 
+		search_running = false;
+		QMetaObject::invokeMethod(this, "solution_update", Qt::QueuedConnection);
+	});
+}
 
-	std::vector<std::vector<glm::dvec2>> best_solution = kinematics::findValidSolution(poses, solutions);
-	kinematics.diagram.joints[0]->pos = best_solution[0][0];
-	kinematics.diagram.joints[1]->pos = best_solution[0][1];
-	kinematics.diagram.joints[2]->pos = best_solution[1][0];
-	kinematics.diagram.joints[3]->pos = best_solution[1][1];
+/**
+ * Interrupt the background search, and wait until the thread finishes.
+ */
+void Canvas::cancelSolutionSearch() {
+	search_cancelled = true;
+	if (search_thread.joinable()) {
+		search_thread.join();
+	}
+	search_running = false;
+}
+
+/**
+ * Apply the best solution found so far to the linkage.
+ */
+void Canvas::solution_update() {
+	kinematics::SolutionCandidate best;
+	{
+		std::lock_guard<std::mutex> lock(search_mutex);
+		best = search_best;
+	}
+
+	if (best.order < 0) {
+		if (!search_running && !search_cancelled) {
+			std::cout << "No solution was found." << std::endl;
+		}
+		update();
+		return;
+	}
+
+	kinematics.diagram.joints[0]->pos = best.C1;
+	kinematics.diagram.joints[1]->pos = best.C2;
+	kinematics.diagram.joints[2]->pos = best.X1;
+	kinematics.diagram.joints[3]->pos = best.X2;
 
 	// update the geometry
 	kinematics.diagram.bodies.clear();
@@ -165,12 +264,11 @@ void Canvas::open(const QString& filename) {
 
 	// setup the kinematic system
 	kinematics.diagram.initialize();
-	update();
 
 	grashofDefect = checkGrashofDefect();
 	orderDefect = checkOrderDefect();
 	branchDefect = checkBranchDefect();
-
+	crank_range = calculateCrankRange();
 
 	update();
 }
@@ -252,19 +350,7 @@ std::pair<int, int> Canvas::findSolution(bool center_point_curve, const glm::dve
 		offset = 0;
 	}
 
-	std::pair<int, int> ans = { -1, -1 };
-	double min_dist = std::numeric_limits<double>::max();
-	for (int i = 0; i < solutions[offset].size(); i++) {
-		for (int j = 0; j < solutions[offset][i].size(); j++) {
-			double dist = glm::length(solutions[offset][i][j] - pt);
-			if (dist < min_dist) {
-				min_dist = dist;
-				ans = { i, j };
-			}
-		}
-	}
-
-	return ans;
+	return solution_indices[offset].findNearest(pt);
 }
 
 /**
@@ -336,6 +422,28 @@ bool Canvas::checkGrashofDefect() {
 	}
 }
 
+/**
+ * Sweep the crank of the current linkage over a full revolution by the closed-form solver,
+ * and return the range of the crank angle in degrees where the linkage can be assembled in its current branch.
+ * -1 is returned if the diagram is not a four-bar linkage.
+ */
+double Canvas::calculateCrankRange() {
+	const int N = 3600;
+	kinematics::DyadLinkageBlock block;
+	block.resize(N);
+	for (int i = 0; i < N; i++) {
+		block.angle[i] = kinematics::M_PI * 2 * i / N;
+	}
+	if (!kinematics.sweep(block)) return -1;
+
+	int count = 0;
+	for (int i = 0; i < N; i++) {
+		if (block.valid[i]) count++;
+	}
+
+	return 360.0 * count / N;
+}
+
 /**
  * Check if the linkage has order defect.
  * If there is an order defect, true is returned.
@@ -553,35 +661,7 @@ void Canvas::paintEvent(QPaintEvent *e) {
 	if (showCenterPointCurve) {
 		// draw center point curve
 		if (solutions.size() == 2) {
-			for (int i = 0; i < extreme_poses.size(); i++) {
-				for (int j = 0; j < extreme_poses[i].size(); j++) {
-					int index = std::get<0>(extreme_poses[i][j]);
-					int pose1 = std::get<1>(extreme_poses[i][j]);
-					int pose2 = std::get<2>(extreme_poses[i][j]);
-					if (pose1 == -1 || pose2 == -1) {
-						painter.setPen(QPen(QColor(0, 0, 255), 1));
-						painter.setBrush(QBrush(QColor(0, 0, 255)));
-					}
-					else {
-						painter.setPen(QPen(QColor(0, 0, 255), 3));
-						painter.setBrush(QBrush(QColor(0, 0, 255)));
-					}
-
-					int end;
-					if (j < extreme_poses[i].size() - 1) {
-						end = std::get<0>(extreme_poses[i][j + 1]);
-					}
-					else {
-						end = solutions[1][i].size();
-					}
-
-					for (int k = index; k < end; k++) {
-						int next = (k + 1) % solutions[0][i].size();
-						if (glm::length(solutions[0][i][k] - solutions[0][i][next]) > 20) continue;
-						painter.drawLine(origin.x() + solutions[0][i][k].x * scale, origin.y() - solutions[0][i][k].y * scale, origin.x() + solutions[0][i][next].x * scale, origin.y() - solutions[0][i][next].y * scale);
-					}
-				}
-			}
+			drawSolutionCurve(painter, solutions[0], QColor(0, 0, 255));
 		}
 
 		// draw poles
@@ -605,11 +685,11 @@ void Canvas::paintEvent(QPaintEvent *e) {
 				for (int j = 0; j < pole_intersections[0][i].size(); j++) {
 					painter.setPen(QPen(QColor(0, 0, 0), 1));
 					painter.setBrush(QBrush(QColor(0, 255, 255)));
-					painter.drawEllipse(QPoint(origin.x() + solutions[0][i][pole_intersections[0][i][j].index].x * scale, origin.y() - solutions[0][i][pole_intersections[0][i][j].index].y * scale), 3, 3);
+					painter.drawEllipse(QPoint(origin.x() + solutions[0].point(i, pole_intersections[0][i][j].index).x * scale, origin.y() - solutions[0].point(i, pole_intersections[0][i][j].index).y * scale), 3, 3);
 
 					painter.setPen(QPen(QColor(0, 0, 0), 1));
 					QString text = QString("Q%1%2").arg(pole_intersections[0][i][j].subscript.first + 1).arg(pole_intersections[0][i][j].subscript.second + 1);
-					painter.drawText(origin.x() + solutions[0][i][pole_intersections[0][i][j].index].x * scale + 5, origin.y() - solutions[0][i][pole_intersections[0][i][j].index].y * scale - 4, text);
+					painter.drawText(origin.x() + solutions[0].point(i, pole_intersections[0][i][j].index).x * scale + 5, origin.y() - solutions[0].point(i, pole_intersections[0][i][j].index).y * scale - 4, text);
 				}
 			}
 		}
@@ -618,35 +698,7 @@ void Canvas::paintEvent(QPaintEvent *e) {
 	if (showCirclePointCurve) {
 		// draw circle point curve
 		if (solutions.size() == 2) {
-			for (int i = 0; i < extreme_poses.size(); i++) {
-				for (int j = 0; j < extreme_poses[i].size(); j++) {
-					int index = std::get<0>(extreme_poses[i][j]);
-					int pose1 = std::get<1>(extreme_poses[i][j]);
-					int pose2 = std::get<2>(extreme_poses[i][j]);
-					if (pose1 == -1 || pose2 == -1) {
-						painter.setPen(QPen(QColor(255, 0, 0), 1));
-						painter.setBrush(QBrush(QColor(255, 0, 0)));
-					}
-					else {
-						painter.setPen(QPen(QColor(255, 0, 0), 3));
-						painter.setBrush(QBrush(QColor(255, 0, 0)));
-					}
-
-					int end;
-					if (j < extreme_poses[i].size() - 1) {
-						end = std::get<0>(extreme_poses[i][j + 1]);
-					}
-					else {
-						end = solutions[1][i].size();
-					}
-
-					for (int k = index; k < end; k++) {
-						int next = (k + 1) % solutions[1][i].size();
-						if (glm::length(solutions[1][i][k] - solutions[1][i][next]) > 20) continue;
-						painter.drawLine(origin.x() + solutions[1][i][k].x * scale, origin.y() - solutions[1][i][k].y * scale, origin.x() + solutions[1][i][next].x * scale, origin.y() - solutions[1][i][next].y * scale);
-					}
-				}
-			}
+			drawSolutionCurve(painter, solutions[1], QColor(255, 0, 0));
 		}
 
 		// draw poles
@@ -670,11 +722,11 @@ void Canvas::paintEvent(QPaintEvent *e) {
 				for (int j = 0; j < pole_intersections[1][i].size(); j++) {
 					painter.setPen(QPen(QColor(0, 0, 0), 1));
 					painter.setBrush(QBrush(QColor(0, 255, 255)));
-					painter.drawEllipse(QPoint(origin.x() + solutions[1][i][pole_intersections[1][i][j].index].x * scale, origin.y() - solutions[1][i][pole_intersections[1][i][j].index].y * scale), 3, 3);
+					painter.drawEllipse(QPoint(origin.x() + solutions[1].point(i, pole_intersections[1][i][j].index).x * scale, origin.y() - solutions[1].point(i, pole_intersections[1][i][j].index).y * scale), 3, 3);
 
 					painter.setPen(QPen(QColor(0, 0, 0), 1));
 					QString text = QString("Q%1%2'").arg(pole_intersections[1][i][j].subscript.first + 1).arg(pole_intersections[1][i][j].subscript.second + 1);
-					painter.drawText(origin.x() + solutions[1][i][pole_intersections[1][i][j].index].x * scale + 5, origin.y() - solutions[1][i][pole_intersections[1][i][j].index].y * scale - 4, text);
+					painter.drawText(origin.x() + solutions[1].point(i, pole_intersections[1][i][j].index).x * scale + 5, origin.y() - solutions[1].point(i, pole_intersections[1][i][j].index).y * scale - 4, text);
 				}
 			}
 		}
@@ -695,11 +747,11 @@ void Canvas::paintEvent(QPaintEvent *e) {
 			for (int j = 0; j < UTs[i].size(); j++) {
 				painter.setPen(QPen(QColor(0, 0, 0), 1));
 				painter.setBrush(QBrush(QColor(255, 255, 0)));
-				painter.drawEllipse(QPoint(origin.x() + solutions[1][i][UTs[i][j].index].x * scale, origin.y() - solutions[1][i][UTs[i][j].index].y * scale), 3, 3);
+				painter.drawEllipse(QPoint(origin.x() + solutions[1].point(i, UTs[i][j].index).x * scale, origin.y() - solutions[1].point(i, UTs[i][j].index).y * scale), 3, 3);
 
 				painter.setPen(QPen(QColor(0, 0, 0), 1));
 				QString text = QString("U%1%2").arg(UTs[i][j].subscript.first + 1).arg(UTs[i][j].subscript.second + 1);
-				painter.drawText(origin.x() + solutions[1][i][UTs[i][j].index].x * scale + 5, origin.y() - solutions[1][i][UTs[i][j].index].y * scale - 4, text);
+				painter.drawText(origin.x() + solutions[1].point(i, UTs[i][j].index).x * scale + 5, origin.y() - solutions[1].point(i, UTs[i][j].index).y * scale - 4, text);
 			}
 		}
 
@@ -796,7 +848,7 @@ void Canvas::paintEvent(QPaintEvent *e) {
 		painter.drawPolygon(pts);
 	}
 
-	kinematics.draw(painter, origin, scale);
+	kinematics::draw(painter, kinematics, origin, scale);
 
 	painter.setPen(QPen(QColor(0, 0, 0)));
 	if (linkage_type >= 0) {
@@ -825,6 +877,16 @@ void Canvas::paintEvent(QPaintEvent *e) {
 			painter.drawText(QPoint(6, 20), "Non-Grashof (0-pi rocker)");
 		}
 	}
+	if (search_running) {
+		painter.drawText(QPoint(6, 84), QString("Searching the solution... %1%").arg(search_progress.load()));
+	}
+	if (crank_range >= 360) {
+		painter.drawText(QPoint(6, 100), "Full rotation of the crank");
+	}
+	else if (crank_range >= 0) {
+		painter.drawText(QPoint(6, 100), QString("Range of the crank: %1 deg").arg(crank_range, 0, 'f', 1));
+	}
+
 	painter.setPen(QPen(QColor(255, 0, 0)));
 	if (grashofDefect) {
 		painter.drawText(QPoint(6, 36), "Grashof defect");
@@ -837,6 +899,33 @@ void Canvas::paintEvent(QPaintEvent *e) {
 	}
 }
 
+/**
+ * Draw the solution curve, whose segments that have the extreme poses are drawn in bold.
+ * The segments are taken from the extreme pose index, and the curve has the same point indices as the circle point curve.
+ */
+void Canvas::drawSolutionCurve(QPainter& painter, const kinematics::CurveSet& curve, const QColor& color) {
+	int loop = 0;
+	for (int s = 0; s < extreme_pose_index.starts.size(); s++) {
+		int start = extreme_pose_index.starts[s];
+		while (loop < curve.numLoops() - 1 && curve.offsets[loop + 1] <= start) loop++;
+		int end = (s < extreme_pose_index.starts.size() - 1) ? std::min(extreme_pose_index.starts[s + 1], curve.offsets[loop + 1]) : curve.offsets[loop + 1];
+
+		if (extreme_pose_index.pose1[s] == -1 || extreme_pose_index.pose2[s] == -1) {
+			painter.setPen(QPen(color, 1));
+		}
+		else {
+			painter.setPen(QPen(color, 3));
+		}
+		painter.setBrush(QBrush(color));
+
+		for (int k = start; k < end; k++) {
+			int next = (k + 1 < curve.offsets[loop + 1]) ? k + 1 : curve.offsets[loop];
+			if (glm::length(curve.point(k) - curve.point(next)) > 20) continue;
+			painter.drawLine(origin.x() + curve.point(k).x * scale, origin.y() - curve.point(k).y * scale, origin.x() + curve.point(next).x * scale, origin.y() - curve.point(next).y * scale);
+		}
+	}
+}
+
 void Canvas::mousePressEvent(QMouseEvent* e) {
 	if (e->buttons() & Qt::LeftButton) {
 		// convert the mouse position to the world coordinate system
@@ -875,6 +964,7 @@ void Canvas::mouseMoveEvent(QMouseEvent* e) {
 			grashofDefect = checkGrashofDefect();
 			orderDefect = checkOrderDefect();
 			branchDefect = checkBranchDefect();
+			crank_range = calculateCrankRange();
 		}
 		else {
 			// select a solution
@@ -886,28 +976,28 @@ void Canvas::mouseMoveEvent(QMouseEvent* e) {
 			if (selectedJoint->ground) {
 				offset = 0;
 			}
-			selectedJoint->pos = solutions[offset][selectedSolution.first][selectedSolution.second];
+			selectedJoint->pos = solutions[offset].point(selectedSolution.first, selectedSolution.second);
 
 			// move the other end joint
 			if (selectedJoint->ground) {
-				kinematics.diagram.joints[selectedJoint->id + 2]->pos = solutions[1][selectedSolution.first][selectedSolution.second];
+				kinematics.diagram.joints[selectedJoint->id + 2]->pos = solutions[1].point(selectedSolution.first, selectedSolution.second);
 			}
 			else {
-				kinematics.diagram.joints[selectedJoint->id - 2]->pos = solutions[0][selectedSolution.first][selectedSolution.second];
+				kinematics.diagram.joints[selectedJoint->id - 2]->pos = solutions[0].point(selectedSolution.first, selectedSolution.second);
 			}
 
 			// initialize the other link
 			if (selectedJoint->ground) {
 				int joint_id = 1 - selectedJoint->id;
 				std::pair<int, int> sol_index = findSolution(selectedJoint->ground, kinematics.diagram.joints[joint_id]->pos);
-				kinematics.diagram.joints[joint_id]->pos = solutions[0][sol_index.first][sol_index.second];
-				kinematics.diagram.joints[joint_id + 2]->pos = solutions[1][sol_index.first][sol_index.second];
+				kinematics.diagram.joints[joint_id]->pos = solutions[0].point(sol_index.first, sol_index.second);
+				kinematics.diagram.joints[joint_id + 2]->pos = solutions[1].point(sol_index.first, sol_index.second);
 			}
 			else {
 				int joint_id = 5 - selectedJoint->id;
 				std::pair<int, int> sol_index = findSolution(selectedJoint->ground, kinematics.diagram.joints[joint_id]->pos);
-				kinematics.diagram.joints[joint_id - 2]->pos = solutions[0][sol_index.first][sol_index.second];
-				kinematics.diagram.joints[joint_id]->pos = solutions[1][sol_index.first][sol_index.second];
+				kinematics.diagram.joints[joint_id - 2]->pos = solutions[0].point(sol_index.first, sol_index.second);
+				kinematics.diagram.joints[joint_id]->pos = solutions[1].point(sol_index.first, sol_index.second);
 			}
 
 			// update the geometry
@@ -921,6 +1011,7 @@ void Canvas::mouseMoveEvent(QMouseEvent* e) {
 			grashofDefect = checkGrashofDefect();
 			orderDefect = checkOrderDefect();
 			branchDefect = checkBranchDefect();
+			crank_range = calculateCrankRange();
 		}
 	}
 	else {
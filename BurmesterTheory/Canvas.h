@@ -5,8 +5,11 @@
 #include <QKeyEvent>
 #include <glm/glm.hpp>
 #include <boost/shared_ptr.hpp>
-#include <kinematics.h>
+#include <kinematicsQt.h>
 #include <QTimer>
+#include <thread>
+#include <atomic>
+#include <mutex>
 
 class Canvas : public QWidget {
 Q_OBJECT
@@ -21,12 +24,14 @@ public:
 	QPoint prev_mouse_pt;
 	QPoint origin;
 	double scale;
-	std::vector<std::vector<std::vector<glm::dvec2>>> solutions;
-	std::vector<std::vector<std::vector<glm::dvec2>>> poles;
+	std::vector<kinematics::CurveSet> solutions;
+	std::vector<kinematics::CurveIndex> solution_indices;
+	kinematics::PoseSet<4>::PoleTable poles;
 	std::vector<std::vector<std::vector<kinematics::SpecialPoint>>> pole_intersections;
 	std::vector<std::vector<kinematics::SpecialPoint>> UTs;
 	std::vector<glm::dvec2> Bs;
 	std::vector<std::vector<std::tuple<int, int, int>>> extreme_poses;
+	kinematics::ExtremePoseIndex extreme_pose_index;
 	double alpha;
 	std::pair<int, int> selectedSolution;
 	boost::shared_ptr<kinematics::Joint> selectedJoint;
@@ -36,14 +41,25 @@ public:
 	bool grashofDefect;
 	bool orderDefect;
 	bool branchDefect;
+	double crank_range;
 	bool showCenterPointCurve;
 	bool showCirclePointCurve;
+	std::thread search_thread;
+	std::atomic<bool> search_cancelled;
+	std::atomic<bool> search_running;
+	std::atomic<int> search_progress;
+	std::mutex search_mutex;
+	kinematics::SolutionCandidate search_best;
+	kinematics::SolutionCache solution_cache;
+	std::string search_cache_key;
 
 public:
 	Canvas(QWidget *parent = NULL);
     ~Canvas();
 
 	void open(const QString& filename);
+	void startSolutionSearch();
+	void cancelSolutionSearch();
 	void run();
 	void stop();
 	void speedUp();
@@ -58,14 +74,17 @@ public:
 	std::pair<int, int> findSolution(bool center_point_curve, const glm::dvec2& pt);
 	int getGrashofType();
 	bool checkGrashofDefect();
+	double calculateCrankRange();
 	bool checkOrderDefect();
 	bool checkBranchDefect();
 
 public slots:
 	void animation_update();
+	void solution_update();
 
 protected:
 	void paintEvent(QPaintEvent* e);
+	void drawSolutionCurve(QPainter& painter, const kinematics::CurveSet& curve, const QColor& color);
 	void mousePressEvent(QMouseEvent* e);
 	void mouseMoveEvent(QMouseEvent* e);
 	void mouseReleaseEvent(QMouseEvent* e);
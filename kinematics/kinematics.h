@@ -2,6 +2,9 @@
 
 #include "kinematics/Kinematics.h"
 #include "kinematics/KinematicDiagram.h"
+#include "kinematics/SolveSchedule.h"
+#include "kinematics/CompactDiagram.h"
+#include "kinematics/DyadLinkage.h"
 #include "kinematics/Joint.h"
 #include "kinematics/PinJoint.h"
 #include "kinematics/SliderHinge.h"
@@ -9,4 +12,12 @@
 #include "kinematics/Link.h"
 #include "kinematics/BodyGeometry.h"
 #include "kinematics/KinematicUtils.h"
-#include "kinematics/Burmester.h"
\ No newline at end of file
+#include "kinematics/Burmester.h"
+#include "kinematics/CurveIndex.h"
+#include "kinematics/CurveSet.h"
+#include "kinematics/PoseSet.h"
+#include "kinematics/PoseFile.h"
+#include "kinematics/ExtremePoseIndex.h"
+#include "kinematics/BurmesterSolver.h"
+#include "kinematics/SolutionCache.h"
+#include "kinematics/CurveFile.h"
\ No newline at end of file
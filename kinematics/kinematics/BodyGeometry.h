@@ -3,8 +3,7 @@
 #include <vector>
 #include <boost/shared_ptr.hpp>
 #include <glm/glm.hpp>
-#include <QPainter>
-#include <QMap>
+#include <map>
 
 namespace kinematics {
 
@@ -15,13 +14,13 @@ namespace kinematics {
 		boost::shared_ptr<Joint> pivot1;
 		boost::shared_ptr<Joint> pivot2;
 		std::vector<glm::dvec2> points;
-		QMap<int, bool> neighbors;
+		std::map<int, bool> neighbors;
 
 	public:
 		BodyGeometry(boost::shared_ptr<Joint> pivot1, boost::shared_ptr<Joint> pivot2) : pivot1(pivot1), pivot2(pivot2) {}
 
-		std::vector<glm::dvec2> getActualPoints();
-		void draw(QPainter& painter, const QPointF& origin, float scale);
+		std::vector<glm::dvec2> getActualPoints() const;
+		static void getActualPoints(const glm::dvec2& pivot1, const glm::dvec2& pivot2, const glm::dvec2* points, int num_points, std::vector<glm::dvec2>& actual_points);
 	};
 
 }
\ No newline at end of file
@@ -1,5 +1,11 @@
 #include "Burmester.h"
 #include "KinematicUtils.h"
+#include "SimdLanes.h"
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <unordered_map>
 
 namespace kinematics {
 
@@ -7,194 +13,437 @@ namespace kinematics {
 		return p1.index < p2.index;
 	}
 
-	void calculateSolutionCurve(const std::vector<glm::dmat4x4>& poses, std::vector<std::vector<std::vector<glm::dvec2>>>& solutions) {
-		// calculate the coordinates of two points on the coupler
-		std::vector<std::vector<glm::dvec2>> points(poses.size());
-		for (int i = 0; i < poses.size(); i++) {
-			glm::dvec2 a(poses[i] * glm::dvec4(0, 0, 0, 1));
-			glm::dvec2 b(poses[i] * glm::dvec4(0.843, 0, 0, 1));
+	void calculateSolutionCurve(const std::vector<glm::dmat4x4>& poses, std::vector<CurveSet>& solutions, const CurveSamplingParams& params) {
+		calculateSolutionCurve(PoseSet<4>(poses), solutions, params);
+	}
+
+	/**
+	 * Calculate the center point curve and the circle point curve from the poles and the angles of the pose set.
+	 */
+	void calculateSolutionCurve(const PoseSet<4>& pose_set, std::vector<CurveSet>& solutions, const CurveSamplingParams& params) {
+		const PoseSet<4>::PoleTable& P = pose_set.P;
+		double theta12 = pose_set.theta[0] - pose_set.theta[1];
+		double theta13 = pose_set.theta[0] - pose_set.theta[2];
+
+		solutions = calculateCenterPointCurve(P[0][0][1], P[0][0][2], P[0][0][3], P[0][1][2], P[0][1][3], theta12, theta13, params);
+	}
+
+	CenterPointCurveSampler::CenterPointCurveSampler(const glm::dvec2& P12, const glm::dvec2& P13, const glm::dvec2& P14, const glm::dvec2& P23, const glm::dvec2& P24, double theta12, double theta13, const CurveSamplingParams& params) : P12(P12), P13(P13), P14(P14), P24(P24), theta12(theta12), theta13(theta13), params(params) {
+		// calculate the mid points of P13 and P14, P23 and P24
+		m1 = (P13 + P14) * 0.5;
+		m2 = (P24 + P23) * 0.5;
+
+		// calculate the normal vector
+		v1 = P13 - P14;
+		v1 /= glm::length(v1);
+		h1 = glm::dvec2(-v1.y, v1.x);
+		v2 = P23 - P24;
+		v2 /= glm::length(v2);
+		h2 = glm::dvec2(-v2.y, v2.x);
+
+		// the refinement is applied only around the poles
+		center = (P12 + P13 + P14 + P23 + P24) * 0.2;
+	}
+
+	/**
+	 * Calculate the two center points and the corresponding circle points for the given alpha.
+	 */
+	CurveSample CenterPointCurveSampler::evaluate(double alpha) const {
+		CurveSampleBlock block;
+		block.resize(1);
+		block.alpha[0] = alpha;
+		evaluate(block);
+
+		return block.sample(0);
+	}
 
-			points[i].push_back(a);
-			points[i].push_back(b);
+	void CurveSampleBlock::resize(int n) {
+		alpha.resize(n);
+		valid.resize(n);
+		for (int k = 0; k < 2; k++) {
+			center_x[k].resize(n);
+			center_y[k].resize(n);
+			circle_x[k].resize(n);
+			circle_y[k].resize(n);
 		}
+	}
 
-		// calculate the coordinates of pole_{i,j}
-		std::vector<std::vector<std::vector<glm::dvec2>>> P = calculatePoles(poses);
-		
-		// calculate theta_{12} and theta_{13}
-		double theta1 = M_PI;
-		if (poses[0][0][0] != 0.0) {
-			theta1 = atan2(poses[0][0][1], poses[0][0][0]);
+	CurveSample CurveSampleBlock::sample(int i) const {
+		CurveSample sample;
+		sample.alpha = alpha[i];
+		sample.valid = valid[i] != 0;
+		for (int k = 0; k < 2; k++) {
+			sample.center_pts[k] = glm::dvec2(center_x[k][i], center_y[k][i]);
+			sample.circle_pts[k] = glm::dvec2(circle_x[k][i], circle_y[k][i]);
 		}
-		double theta2 = M_PI;
-		if (poses[1][0][0] != 0.0) {
-			theta2 = atan2(poses[1][0][1], poses[1][0][0]);
+
+		return sample;
+	}
+
+	/**
+	 * Calculate the circle point that corresponds to the center point (Cx, Cy) on the lanes.
+	 * This is the same computation as calculateCirclePointFromCenterPoint.
+	 */
+	template <class Lane>
+	typename Lane::Mask calculateCirclePointLanes(const Lane& Cx, const Lane& Cy, const glm::dvec2& P12, const glm::dvec2& P13, double cos12, double sin12, double cos13, double sin13, Lane& Xx, Lane& Xy) {
+		Lane s1x = Cx - Lane(P12.x);
+		Lane s1y = Cy - Lane(P12.y);
+		Lane len1 = sqrt(s1x * s1x + s1y * s1y);
+		s1x = s1x / len1;
+		s1y = s1y / len1;
+		Lane u1x = Lane(cos12) * s1x - Lane(sin12) * s1y;
+		Lane u1y = Lane(sin12) * s1x + Lane(cos12) * s1y;
+
+		Lane s2x = Cx - Lane(P13.x);
+		Lane s2y = Cy - Lane(P13.y);
+		Lane len2 = sqrt(s2x * s2x + s2y * s2y);
+		s2x = s2x / len2;
+		s2y = s2y / len2;
+		Lane u2x = Lane(cos13) * s2x - Lane(sin13) * s2y;
+		Lane u2y = Lane(sin13) * s2x + Lane(cos13) * s2y;
+
+		// the intersection of the line through P12 along u1 and the line through P13 along u2
+		Lane numer = u2x * Lane(P13.y - P12.y) + u2y * Lane(P12.x - P13.x);
+		Lane denom = u1y * u2x - u1x * u2y;
+		Lane t0 = numer / denom;
+		Xx = Lane(P12.x) + t0 * u1x;
+		Xy = Lane(P12.y) + t0 * u1y;
+
+		return (!(sqrt(u1x * u1x + u1y * u1y) < Lane(TOL))) & (denom != Lane(0.0));
+	}
+
+	/**
+	 * Evaluate the lanes of the block starting at i.
+	 * This is the same computation as lineLineIntersection, circleCircleIntersection, and calculateCirclePointFromCenterPoint,
+	 * but the exceptional cases are recorded in the feasibility mask instead of returning early.
+	 * Since every operation is done in the same order, the results are identical to the scalar code.
+	 */
+	template <class Lane>
+	void evaluateLanes(const CenterPointCurveSampler& sampler, const double* cos_alpha, const double* sin_alpha, double cos12, double sin12, double cos13, double sin13, CurveSampleBlock& block, int i) {
+		typedef typename Lane::Mask Mask;
+
+		Lane ca = Lane::load(cos_alpha + i);
+		Lane sa = Lane::load(sin_alpha + i);
+
+		// M1 is the intersection of the bisector of P13 and P14 and the line through P14 along v1 rotated by alpha
+		Lane u1x = ca * Lane(sampler.v1.x) - sa * Lane(sampler.v1.y);
+		Lane u1y = sa * Lane(sampler.v1.x) + ca * Lane(sampler.v1.y);
+		Lane numer1 = u1x * Lane(sampler.P14.y - sampler.m1.y) + u1y * Lane(sampler.m1.x - sampler.P14.x);
+		Lane denom1 = Lane(sampler.h1.y) * u1x - Lane(sampler.h1.x) * u1y;
+		Lane t1 = numer1 / denom1;
+		Lane M1x = Lane(sampler.m1.x) + t1 * Lane(sampler.h1.x);
+		Lane M1y = Lane(sampler.m1.y) + t1 * Lane(sampler.h1.y);
+		Lane d1x = Lane(sampler.P14.x) - M1x;
+		Lane d1y = Lane(sampler.P14.y) - M1y;
+		Lane r1 = sqrt(d1x * d1x + d1y * d1y);
+
+		// M2 is the intersection of the bisector of P23 and P24 and the line through P24 along v2 rotated by alpha
+		Lane u2x = ca * Lane(sampler.v2.x) - sa * Lane(sampler.v2.y);
+		Lane u2y = sa * Lane(sampler.v2.x) + ca * Lane(sampler.v2.y);
+		Lane numer2 = u2x * Lane(sampler.P24.y - sampler.m2.y) + u2y * Lane(sampler.m2.x - sampler.P24.x);
+		Lane denom2 = Lane(sampler.h2.y) * u2x - Lane(sampler.h2.x) * u2y;
+		Lane t2 = numer2 / denom2;
+		Lane M2x = Lane(sampler.m2.x) + t2 * Lane(sampler.h2.x);
+		Lane M2y = Lane(sampler.m2.y) + t2 * Lane(sampler.h2.y);
+		Lane d2x = Lane(sampler.P24.x) - M2x;
+		Lane d2y = Lane(sampler.P24.y) - M2y;
+		Lane r2 = sqrt(d2x * d2x + d2y * d2y);
+
+		Mask valid = (denom1 != Lane(0.0)) & (denom2 != Lane(0.0));
+
+		// intersect the two circles
+		Lane dirx = M2x - M1x;
+		Lane diry = M2y - M1y;
+		Lane d = sqrt(dirx * dirx + diry * diry);
+		Lane sum = r1 + r2;
+		Lane diff = abs(r1 - r2);
+		Mask apart = (d > sum) | (d < diff);
+		Mask touching = apart & (d <= sum + Lane(TOL)) & (d > sum);
+		Mask inside = apart & !touching & (d >= diff - Lane(TOL)) & (d < diff);
+		valid = valid & ((!apart) | touching | inside);
+		d = select(inside, diff, d);
+
+		Lane a = (r1 * r1 - r2 * r2 + d * d) / d / Lane(2.0);
+		Lane h = sqrt(max(Lane(0.0), r1 * r1 - a * a));
+		Lane perp_len = sqrt(diry * diry + dirx * dirx);
+		Lane px = diry / perp_len;
+		Lane py = -dirx / perp_len;
+		Lane bx = M1x + dirx * a / d;
+		Lane by = M1y + diry * a / d;
+		Lane tx = M1x + dirx / sum * r1;
+		Lane ty = M1y + diry / sum * r1;
+
+		Lane Cx[2] = { select(touching, tx, bx + px * h), select(touching, tx, bx - px * h) };
+		Lane Cy[2] = { select(touching, ty, by + py * h), select(touching, ty, by - py * h) };
+
+		// calculate the corresponding circle points
+		for (int k = 0; k < 2; k++) {
+			Lane Xx, Xy;
+			valid = valid & calculateCirclePointLanes(Cx[k], Cy[k], sampler.P12, sampler.P13, cos12, sin12, cos13, sin13, Xx, Xy);
+
+			Cx[k].store(&block.center_x[k][i]);
+			Cy[k].store(&block.center_y[k][i]);
+			Xx.store(&block.circle_x[k][i]);
+			Xy.store(&block.circle_y[k][i]);
 		}
-		double theta3 = M_PI;
-		if (poses[2][0][0] != 0.0) {
-			theta3 = atan2(poses[2][0][1], poses[2][0][0]);
+		valid.store(&block.valid[i]);
+	}
+
+	/**
+	 * Calculate the center points and the corresponding circle points for all the alpha values of the block.
+	 * The lanes are evaluated with SIMD instructions if they are available, and the remainder with the scalar code.
+	 */
+	void CenterPointCurveSampler::evaluate(CurveSampleBlock& block) const {
+		int n = block.size();
+		block.resize(n);
+
+		std::vector<double> cos_alpha(n);
+		std::vector<double> sin_alpha(n);
+		for (int i = 0; i < n; i++) {
+			cos_alpha[i] = cos(block.alpha[i]);
+			sin_alpha[i] = sin(block.alpha[i]);
 		}
-		double theta12 = theta1 - theta2;
-		double theta13 = theta1 - theta3;
 
-		solutions = calculateCenterPointCurve(P[0][0][1], P[0][0][2], P[0][0][3], P[0][1][2], P[0][1][3], theta12, theta13);
+		double cos12 = cos(theta12 * 0.5);
+		double sin12 = sin(theta12 * 0.5);
+		double cos13 = cos(theta13 * 0.5);
+		double sin13 = sin(theta13 * 0.5);
+
+		int i = 0;
+		for (; i + DoubleLane::width <= n; i += DoubleLane::width) {
+			evaluateLanes<DoubleLane>(*this, cos_alpha.data(), sin_alpha.data(), cos12, sin12, cos13, sin13, block, i);
+		}
+		for (; i < n; i++) {
+			evaluateLanes<ScalarLane>(*this, cos_alpha.data(), sin_alpha.data(), cos12, sin12, cos13, sin13, block, i);
+		}
 	}
 
 	/**
-	 * Calculate the center point curve for the opposite pole quadrilateral, P_{13}, P_{14}, P_{24}, and P_{23}
+	 * Return true if the polyline s0-s1 approximates the curve through mid within the tolerance,
+	 * and the spacing between s0 and s1 is within max_spacing.
+	 * The squared distance between the two center points, which becomes zero where the circles stop intersecting,
+	 * is interpolated by the parabola through the three samples, and if it drops below zero within the interval,
+	 * the interval may have a gap, so false is returned.
 	 */
-	std::vector<std::vector<std::vector<glm::dvec2>>> calculateCenterPointCurve(const glm::dvec2& P12, const glm::dvec2& P13, const glm::dvec2& P14, const glm::dvec2& P23, const glm::dvec2& P24, double theta12, double theta13) {
-		std::vector<std::vector<std::vector<glm::dvec2>>> curves(2);
-
-		// calculate the mid points of P13 and P14, P23 and P24
-		glm::dvec2 m1 = (P13 + P14) * 0.5;
-		glm::dvec2 m2 = (P24 + P23) * 0.5;
+	bool CenterPointCurveSampler::isAccurate(const CurveSample& s0, const CurveSample& mid, const CurveSample& s1) const {
+		if (!s0.valid || !s1.valid || !mid.valid) return false;
+
+		double q0 = glm::dot(s0.center_pts[0] - s0.center_pts[1], s0.center_pts[0] - s0.center_pts[1]);
+		double qm = glm::dot(mid.center_pts[0] - mid.center_pts[1], mid.center_pts[0] - mid.center_pts[1]);
+		double q1 = glm::dot(s1.center_pts[0] - s1.center_pts[1], s1.center_pts[0] - s1.center_pts[1]);
+		double b = (q1 - q0) * 0.5;
+		double c = (q0 + q1) * 0.5 - qm;
+		if (c > 0 && std::abs(b) < 2 * c && qm - b * b / (4 * c) < 0) return false;
+
+		double error = 0.0;
+		double spacing = 0.0;
+		for (int k = 0; k < 2; k++) {
+			if (pointSegmentDistance(center, s0.center_pts[k], s1.center_pts[k]) < params.max_radius) {
+				error = std::max(error, pointSegmentDistance(mid.center_pts[k], s0.center_pts[k], s1.center_pts[k]));
+				spacing = std::max(spacing, glm::length(s1.center_pts[k] - s0.center_pts[k]));
+			}
+			if (pointSegmentDistance(center, s0.circle_pts[k], s1.circle_pts[k]) < params.max_radius) {
+				error = std::max(error, pointSegmentDistance(mid.circle_pts[k], s0.circle_pts[k], s1.circle_pts[k]));
+				spacing = std::max(spacing, glm::length(s1.circle_pts[k] - s0.circle_pts[k]));
+			}
+		}
 
-		// calculate the normal vector
-		glm::dvec2 v1 = P13 - P14;
-		v1 /= glm::length(v1);
-		glm::dvec2 h1(-v1.y, v1.x);
-		glm::dvec2 v2 = P23 - P24;
-		v2 /= glm::length(v2);
-		glm::dvec2 h2(-v2.y, v2.x);
-
-		// calculate the circle points
-		bool inloop = false;
-		std::vector<std::vector<glm::dvec2>> center_loops(2);
-		std::vector<std::vector<glm::dvec2>> circle_loops(2);
-		for (double alpha = -kinematics::M_PI * 0.5 + 0.001; alpha <= kinematics::M_PI * 0.5 - 0.001; alpha += 0.001) {
-			glm::dvec2 u1(cos(alpha) * v1.x - sin(alpha) * v1.y, sin(alpha) * v1.x + cos(alpha) * v1.y);
-			glm::dvec2 M1;
-			kinematics::lineLineIntersection(m1, h1, P14, u1, M1);
-			double r1 = glm::length(P14 - M1);
-
-			glm::dvec2 u2(cos(alpha) * v2.x - sin(alpha) * v2.y, sin(alpha) * v2.x + cos(alpha) * v2.y);
-			glm::dvec2 M2;
-			kinematics::lineLineIntersection(m2, h2, P24, u2, M2);
-			double r2 = glm::length(P24 - M2);
-
-			glm::dvec2 C1, C2;
-			try {
-				C1 = kinematics::circleCircleIntersection(M1, r1, M2, r2);
-				C2 = kinematics::circleCircleIntersection(M2, r2, M1, r1);
-
-				// calculate the corresponding circle point
-				if (glm::length(C1 - glm::dvec2(3.65, 3.9)) < 0.1 || glm::length(C2 - glm::dvec2(3.65, 3.9) )< 0.1) {
-					int hoge = 0;
-				}
-				glm::dvec2 circle_pt1 =	calculateCirclePointFromCenterPoint(C1, P12, P13, theta12, theta13);
-				glm::dvec2 circle_pt2 = calculateCirclePointFromCenterPoint(C2, P12, P13, theta12, theta13);
+		return error <= params.tolerance && spacing <= params.max_spacing;
+	}
 
-				if (!inloop) {
-					inloop = true;
+	/**
+	 * Insert samples between the consecutive samples until the chord error and the spacing between consecutive points are within the tolerance.
+	 * The intervals are also bisected down to min_step where the curve starts or ends, so that the end points of the loops are accurate,
+	 * and the intervals that are infeasible at both ends are bisected down to probe_step to find the loops that start and end inside them.
+	 * The intervals are bisected level by level, and the mid points of each level are evaluated as one block.
+	 * The samples must be in the increasing order of alpha, and they are kept in that order.
+	 */
+	void CenterPointCurveSampler::refine(std::vector<CurveSample>& samples) const {
+		if (samples.size() < 2) return;
+
+		// open[i] is true if the interval between samples[i] and samples[i + 1] may need to be bisected
+		std::vector<bool> open(samples.size() - 1, true);
+		while (true) {
+			std::vector<int> intervals;
+			CurveSampleBlock block;
+			for (int i = 0; i < open.size(); i++) {
+				if (!open[i]) continue;
+				double step = samples[i + 1].alpha - samples[i].alpha;
+				if (step <= params.min_step || (!samples[i].valid && !samples[i + 1].valid && step <= params.probe_step)) {
+					open[i] = false;
+					continue;
 				}
 
-				if (center_loops[0].size() == 0 || glm::length(center_loops[0].back() - C1) > 0.1 || glm::length(center_loops[1].back() - C2) > 0.1 || glm::length(circle_loops[0].back() - circle_pt1) > 0.1 || glm::length(circle_loops[1].back() - circle_pt2) > 0.1) {
-					center_loops[0].push_back(C1);
-					center_loops[1].push_back(C2);
-					circle_loops[0].push_back(circle_pt1);
-					circle_loops[1].push_back(circle_pt2);
-				}
+				intervals.push_back(i);
+				block.alpha.push_back((samples[i].alpha + samples[i + 1].alpha) * 0.5);
 			}
-			catch (char* ex) {
-				if (center_loops[0].size() > 0) {
-					curves[0].resize(curves[0].size() + 1);
-					curves[1].resize(curves[1].size() + 1);
-
-					double d1 = glm::length(center_loops[0].front() - center_loops[1].front());
-					double d2 = glm::length(circle_loops[0].front() - circle_loops[1].front());
-					double d3 = glm::length(center_loops[0].back() - center_loops[1].back());
-					double d4 = glm::length(circle_loops[0].back() - circle_loops[1].back());
-					if ((d1 <= d2 && d1 <= d3 && d1 <= d4) || (d2 <= d3 && d2 <= d4)) {
-						std::reverse(center_loops[0].begin(), center_loops[0].end());
-						std::reverse(circle_loops[0].begin(), circle_loops[0].end());
-					}
-					else {
-						std::reverse(center_loops[1].begin(), center_loops[1].end());
-						std::reverse(circle_loops[1].begin(), circle_loops[1].end());
+			if (intervals.size() == 0) break;
+
+			evaluate(block);
+
+			// insert the mid points where the polyline is not accurate enough
+			std::vector<CurveSample> next_samples;
+			std::vector<bool> next_open;
+			next_samples.reserve(samples.size() + intervals.size());
+			next_open.reserve(open.size() + intervals.size());
+			for (int i = 0, k = 0; i < samples.size(); i++) {
+				next_samples.push_back(samples[i]);
+				if (i == open.size()) break;
+
+				if (k < intervals.size() && intervals[k] == i) {
+					CurveSample mid = block.sample(k++);
+					if (!isAccurate(samples[i], mid, samples[i + 1])) {
+						next_samples.push_back(mid);
+						next_open.push_back(true);
+						next_open.push_back(true);
+						continue;
 					}
-
-					curves[0].back().insert(curves[0].back().end(), center_loops[0].begin(), center_loops[0].end());
-					curves[0].back().insert(curves[0].back().end(), center_loops[1].begin(), center_loops[1].end());
-					curves[1].back().insert(curves[1].back().end(), circle_loops[0].begin(), circle_loops[0].end());
-					curves[1].back().insert(curves[1].back().end(), circle_loops[1].begin(), circle_loops[1].end());
-
-					center_loops.clear();
-					center_loops.resize(2);
-					circle_loops.clear();
-					circle_loops.resize(2);
 				}
-				
-				inloop = false;
+				next_open.push_back(false);
 			}
+
+			samples.swap(next_samples);
+			open.swap(next_open);
 		}
+	}
 
-		if (center_loops[0].size() > 0) {
-			curves[0].resize(curves[0].size() + 1);
-			curves[1].resize(curves[1].size() + 1);
+	/**
+	 * Calculate the center point curve for the opposite pole quadrilateral, P_{13}, P_{14}, P_{24}, and P_{23}
+	 */
+	std::vector<CurveSet> calculateCenterPointCurve(const glm::dvec2& P12, const glm::dvec2& P13, const glm::dvec2& P14, const glm::dvec2& P23, const glm::dvec2& P24, double theta12, double theta13, const CurveSamplingParams& params) {
+		CenterPointCurveSampler sampler(P12, P13, P14, P23, P24, theta12, theta13, params);
+
+		// sample alpha on a coarse grid, and refine each interval adaptively
+		double alpha0 = -kinematics::M_PI * 0.5 + 0.001;
+		double alpha1 = kinematics::M_PI * 0.5 - 0.001;
+		int num_steps = std::max(1, (int)ceil((alpha1 - alpha0) / params.max_step));
+
+		int num_threads = params.num_threads;
+		if (num_threads <= 0) num_threads = std::max(1, (int)std::thread::hardware_concurrency());
+		num_threads = std::min(num_threads, num_steps);
+
+		// Since the samples in an interval of the coarse grid depend only on its end points, the grid is partitioned over the threads.
+		// Each thread refines its partition, and finds the runs of the valid samples [start, end) in it.
+		std::vector<std::vector<CurveSample>> partitions(num_threads);
+		std::vector<std::vector<std::pair<int, int>>> partition_runs(num_threads);
+		auto worker = [&](int t) {
+			int first = (long long)num_steps * t / num_threads;
+			int last = (long long)num_steps * (t + 1) / num_threads;
+
+			CurveSampleBlock block;
+			block.resize(last - first + 1);
+			for (int i = first; i <= last; i++) {
+				block.alpha[i - first] = alpha0 + (alpha1 - alpha0) * i / num_steps;
+			}
+			sampler.evaluate(block);
 
-			double d1 = glm::length(center_loops[0].front() - center_loops[1].front());
-			double d2 = glm::length(circle_loops[0].front() - circle_loops[1].front());
-			double d3 = glm::length(center_loops[0].back() - center_loops[1].back());
-			double d4 = glm::length(circle_loops[0].back() - circle_loops[1].back());
-			if ((d1 <= d2 && d1 <= d3 && d1 <= d4) || (d2 <= d3 && d2 <= d4)) {
-				std::reverse(center_loops[0].begin(), center_loops[0].end());
-				std::reverse(circle_loops[0].begin(), circle_loops[0].end());
+			std::vector<CurveSample>& samples = partitions[t];
+			samples.resize(block.size());
+			for (int i = 0; i < block.size(); i++) {
+				samples[i] = block.sample(i);
 			}
-			else {
-				std::reverse(center_loops[1].begin(), center_loops[1].end());
-				std::reverse(circle_loops[1].begin(), circle_loops[1].end());
+			sampler.refine(samples);
+
+			for (int i = 0, start = -1; i <= samples.size(); i++) {
+				if (i < samples.size() && samples[i].valid) {
+					if (start < 0) start = i;
+				}
+				else if (start >= 0) {
+					partition_runs[t].push_back({ start, i });
+					start = -1;
+				}
 			}
+		};
 
-			curves[0].back().insert(curves[0].back().end(), center_loops[0].begin(), center_loops[0].end());
-			curves[0].back().insert(curves[0].back().end(), center_loops[1].begin(), center_loops[1].end());
-			curves[1].back().insert(curves[1].back().end(), circle_loops[0].begin(), circle_loops[0].end());
-			curves[1].back().insert(curves[1].back().end(), circle_loops[1].begin(), circle_loops[1].end());
+		if (num_threads == 1) {
+			worker(0);
+		}
+		else {
+			std::vector<std::thread> threads;
+			for (int i = 0; i < num_threads; i++) {
+				threads.push_back(std::thread(worker, i));
+			}
+			for (int i = 0; i < num_threads; i++) {
+				threads[i].join();
+			}
 		}
 
-		// merge the loops that are connected
-		for (int i = 0; i < curves[1].size() - 1; i++) {
-			for (int j = curves[1].size() - 1; j > i; j--) {
-				if (glm::length(curves[1][i].front() - curves[1][j].front()) < 0.1) {
-					std::reverse(curves[0][j].begin(), curves[0][j].end());
-					std::reverse(curves[1][j].begin(), curves[1][j].end());
-					curves[0][i].insert(curves[0][i].begin(), curves[0][j].begin(), curves[0][j].end());
-					curves[1][i].insert(curves[1][i].begin(), curves[1][j].begin(), curves[1][j].end());
-					curves[0].erase(curves[0].begin() + j);
-					curves[1].erase(curves[1].begin() + j);
+		// Concatenate the partitions in order. The last sample of a partition is the first sample of the next one,
+		// so the runs that meet at the seam are joined, and the result is the same as the serial sweep.
+		std::vector<CurveSample> samples;
+		std::vector<std::pair<int, int>> runs;
+		for (int t = 0; t < num_threads; t++) {
+			int skip = t > 0 ? 1 : 0;
+			int offset = samples.size() - skip;
+			samples.insert(samples.end(), partitions[t].begin() + skip, partitions[t].end());
+
+			for (int k = 0; k < partition_runs[t].size(); k++) {
+				std::pair<int, int> run(partition_runs[t][k].first + offset, partition_runs[t][k].second + offset);
+				if (runs.size() > 0 && runs.back().second == run.first + 1) {
+					runs.back().second = run.second;
 				}
-				else if (glm::length(curves[1][i].back() - curves[1][j].back()) < 0.1) {
-					std::reverse(curves[0][j].begin(), curves[0][j].end());
-					std::reverse(curves[1][j].begin(), curves[1][j].end());
-					curves[0][i].insert(curves[0][i].end(), curves[0][j].begin(), curves[0][j].end());
-					curves[1][i].insert(curves[1][i].end(), curves[1][j].begin(), curves[1][j].end());
-					curves[0].erase(curves[0].begin() + j);
-					curves[1].erase(curves[1].begin() + j);
+				else {
+					runs.push_back(run);
 				}
-				else if (glm::length(curves[1][i].front() - curves[1][j].back()) < 0.1) {
-					curves[0][i].insert(curves[0][i].begin(), curves[0][j].begin(), curves[0][j].end());
-					curves[1][i].insert(curves[1][i].begin(), curves[1][j].begin(), curves[1][j].end());
-					curves[0].erase(curves[0].begin() + j);
-					curves[1].erase(curves[1].begin() + j);
+			}
+		}
+
+		// Each run of the valid samples gives a fragment, in which the two branches of the circle intersections
+		// are joined at the end where they are closest to each other.
+		std::vector<CurveSet> fragments(2);
+		fragments[0].reserve(runs.size(), samples.size() * 2);
+		fragments[1].reserve(runs.size(), samples.size() * 2);
+		for (int r = 0; r < runs.size(); r++) {
+			int start = runs[r].first;
+			int end = runs[r].second;
+
+			double d1 = glm::length(samples[start].center_pts[0] - samples[start].center_pts[1]);
+			double d2 = glm::length(samples[start].circle_pts[0] - samples[start].circle_pts[1]);
+			double d3 = glm::length(samples[end - 1].center_pts[0] - samples[end - 1].center_pts[1]);
+			double d4 = glm::length(samples[end - 1].circle_pts[0] - samples[end - 1].circle_pts[1]);
+			bool reverse_first = (d1 <= d2 && d1 <= d3 && d1 <= d4) || (d2 <= d3 && d2 <= d4);
+
+			fragments[0].addLoop();
+			fragments[1].addLoop();
+			for (int k = 0; k < 2; k++) {
+				bool reverse = (k == 0) == reverse_first;
+				for (int j = 0; j < end - start; j++) {
+					const CurveSample& sample = samples[reverse ? end - 1 - j : start + j];
+					fragments[0].addPoint(sample.center_pts[k]);
+					fragments[1].addPoint(sample.circle_pts[k]);
 				}
-				else if (glm::length(curves[1][i].back() - curves[1][j].front()) < 0.1) {
-					curves[0][i].insert(curves[0][i].end(), curves[0][j].begin(), curves[0][j].end());
-					curves[1][i].insert(curves[1][i].end(), curves[1][j].begin(), curves[1][j].end());
-					curves[0].erase(curves[0].begin() + j);
-					curves[1].erase(curves[1].begin() + j);
+			}
+		}
+
+		// merge the loops that are connected
+		std::vector<std::vector<int>> chains = stitchLoops(fragments[1], params.stitch_distance);
+
+		// copy the points of each chain into the curves at once
+		std::vector<CurveSet> curves(2);
+		curves[0].reserve(chains.size(), fragments[0].numPoints());
+		curves[1].reserve(chains.size(), fragments[1].numPoints());
+		for (int i = 0; i < chains.size(); i++) {
+			curves[0].addLoop();
+			curves[1].addLoop();
+			for (int j = 0; j < chains[i].size(); j++) {
+				int f = chains[i][j] >= 0 ? chains[i][j] : ~chains[i][j];
+				for (int k = 0; k < fragments[0].size(f); k++) {
+					int index = chains[i][j] >= 0 ? fragments[0].offsets[f] + k : fragments[0].offsets[f + 1] - 1 - k;
+					curves[0].addPoint(fragments[0].point(index));
+					curves[1].addPoint(fragments[1].point(index));
 				}
 			}
 		}
 
 		// Reorder the open loop such that it starts at infinity and ends at infinity of the other side.
 		// If the loop is closed, the corresponding circle point curve is an open loop, so reorder the loop in a similar manner.
-		for (int i = 0; i < curves[0].size(); i++) {
+		for (int i = 0; i < curves[0].numLoops(); i++) {
 			double max_dist = 0;
 			int max_j = -1;
-			int n = curves[0][i].size();
+			int n = curves[0].size(i);
 			for (int j = 0; j < n; j++) {
 				int next = (j + 1) % n;
-				double dist = glm::length(curves[0][i][j] - curves[0][i][next]);
+				double dist = glm::length(curves[0].point(i, j) - curves[0].point(i, next));
 				if (dist > max_dist) {
 					max_dist = dist;
 					max_j = j;
@@ -202,17 +451,15 @@ namespace kinematics {
 			}
 
 			if (max_dist > 20) {
-				curves[0][i].insert(curves[0][i].begin(), curves[0][i].begin() + max_j + 1, curves[0][i].end());
-				curves[0][i].resize(n);
-				curves[1][i].insert(curves[1][i].begin(), curves[1][i].begin() + max_j + 1, curves[1][i].end());
-				curves[1][i].resize(n);
+				curves[0].rotateLoop(i, max_j + 1);
+				curves[1].rotateLoop(i, max_j + 1);
 			}
 			else {
 				double max_dist = 0;
 				int max_j = -1;
-				int n = curves[1][i].size();
+				int n = curves[1].size(i);
 				for (int j = 0; j < n - 1; j++) {
-					double dist = glm::length(curves[1][i][j] - curves[1][i][j + 1]);
+					double dist = glm::length(curves[1].point(i, j) - curves[1].point(i, j + 1));
 					if (dist > max_dist) {
 						max_dist = dist;
 						max_j = j;
@@ -220,18 +467,126 @@ namespace kinematics {
 				}
 
 				if (max_dist > 20) {
-					curves[0][i].insert(curves[0][i].begin(), curves[0][i].begin() + max_j + 1, curves[0][i].end());
-					curves[0][i].resize(n);
-					curves[1][i].insert(curves[1][i].begin(), curves[1][i].begin() + max_j + 1, curves[1][i].end());
-					curves[1][i].resize(n);
+					curves[0].rotateLoop(i, max_j + 1);
+					curves[1].rotateLoop(i, max_j + 1);
 				}
 			}
+
+			// the loop is open if it jumps through infinity between the last point and the first point
+			curves[0].closed[i] = glm::length(curves[0].back(i) - curves[0].front(i)) <= 20;
+			curves[1].closed[i] = glm::length(curves[1].back(i) - curves[1].front(i)) <= 20;
 		}
 
 		return curves;
 	}
 
+	/**
+	 * Link the loops whose end points are within max_dist into chains, and return the chains.
+	 * Each chain is a list of the loop indices, in which ~i represents the loop i in the reverse order.
+	 * The end points are hashed into a grid of max_dist cells, so that only the end points in the neighboring cells are compared.
+	 * The end points that are not finite (or too far to be hashed) are not linked.
+	 * Each end point is linked to the closest end point of another loop that has not been linked yet.
+	 * The chains are ordered by the smallest loop index in them, and that loop keeps its direction.
+	 */
+	std::vector<std::vector<int>> stitchLoops(const CurveSet& loops, double max_dist) {
+		int num_loops = loops.numLoops();
+
+		// the end point 2i is the front of the loop i, and 2i + 1 is its back
+		auto endPoint = [&loops](int e) { return e % 2 == 0 ? loops.front(e / 2) : loops.back(e / 2); };
+		auto cellOf = [max_dist](const glm::dvec2& pt, long long& ix, long long& iy) {
+			double x = floor(pt.x / max_dist);
+			double y = floor(pt.y / max_dist);
+			if (!(std::abs(x) < 1e18 && std::abs(y) < 1e18)) return false;
+
+			ix = (long long)x;
+			iy = (long long)y;
+			return true;
+		};
+		auto cellKey = [](long long ix, long long iy) { return ((unsigned long long)ix << 32) ^ ((unsigned long long)iy & 0xffffffffULL); };
+
+		std::unordered_map<unsigned long long, std::vector<int>> grid;
+		grid.reserve(num_loops * 2);
+		for (int e = 0; e < num_loops * 2; e++) {
+			long long ix, iy;
+			if (!cellOf(endPoint(e), ix, iy)) continue;
+
+			grid[cellKey(ix, iy)].push_back(e);
+		}
+
+		// link each end point to the closest free end point of another loop
+		std::vector<int> link(num_loops * 2, -1);
+		for (int e = 0; e < num_loops * 2; e++) {
+			if (link[e] >= 0) continue;
+
+			glm::dvec2 pt = endPoint(e);
+			long long ix, iy;
+			if (!cellOf(pt, ix, iy)) continue;
+
+			int best = -1;
+			double min_dist = max_dist;
+			for (long long x = ix - 1; x <= ix + 1; x++) {
+				for (long long y = iy - 1; y <= iy + 1; y++) {
+					auto it = grid.find(cellKey(x, y));
+					if (it == grid.end()) continue;
+
+					for (int k = 0; k < it->second.size(); k++) {
+						int e2 = it->second[k];
+						if (e2 / 2 == e / 2 || link[e2] >= 0) continue;
+
+						double dist = glm::length(endPoint(e2) - pt);
+						if (dist < min_dist || (dist == min_dist && best >= 0 && e2 < best)) {
+							min_dist = dist;
+							best = e2;
+						}
+					}
+				}
+			}
+
+			if (best >= 0) {
+				link[e] = best;
+				link[best] = e;
+			}
+		}
+
+		// walk along the links from each loop that has not been visited yet
+		std::vector<std::vector<int>> chains;
+		std::vector<bool> visited(num_loops, false);
+		for (int i = 0; i < num_loops; i++) {
+			if (visited[i]) continue;
+
+			// go back from the front of the loop i to the first loop of the chain, or until the chain turns out to be a cycle
+			int start = 2 * i;
+			while (link[start] >= 0 && link[start] / 2 != i) {
+				start = link[start] ^ 1;
+			}
+			if (link[start] >= 0) start = 2 * i;
+
+			chains.resize(chains.size() + 1);
+			for (int e = start; ; ) {
+				visited[e / 2] = true;
+				chains.back().push_back(e % 2 == 0 ? e / 2 : ~(e / 2));
+
+				int next = link[e ^ 1];
+				if (next < 0 || visited[next / 2]) break;
+				e = next;
+			}
+		}
+
+		return chains;
+	}
+
 	glm::dvec2 calculateCirclePointFromCenterPoint(const glm::dvec2& C, const glm::dvec2& P12, const glm::dvec2& P13, double theta12, double theta13) {
+		glm::dvec2 circle_pt;
+		if (!calculateCirclePointFromCenterPoint(C, P12, P13, theta12, theta13, circle_pt)) throw "No circle point";
+
+		return circle_pt;
+	}
+
+	/**
+	 * Calculate the circle point that corresponds to the center point C.
+	 * Return false if the circle point does not exist.
+	 */
+	bool calculateCirclePointFromCenterPoint(const glm::dvec2& C, const glm::dvec2& P12, const glm::dvec2& P13, double theta12, double theta13, glm::dvec2& circle_pt) {
 		glm::dvec2 s1 = C - P12;
 		s1 /= glm::length(s1);
 		s1 = glm::dvec2(cos(theta12 * 0.5) * s1.x - sin(theta12 * 0.5) * s1.y, sin(theta12 * 0.5) * s1.x + cos(theta12 * 0.5) * s1.y);
@@ -239,80 +594,50 @@ namespace kinematics {
 		s2 /= glm::length(s2);
 		s2 = glm::dvec2(cos(theta13 * 0.5) * s2.x - sin(theta13 * 0.5) * s2.y, sin(theta13 * 0.5) * s2.x + cos(theta13 * 0.5) * s2.y);
 
-		glm::dvec2 circle_pt;
-		if (!lineLineIntersection(P12, s1, P13, s2, circle_pt)) throw "No circle point";
-
-		return circle_pt;
+		return lineLineIntersection(P12, s1, P13, s2, circle_pt);
 	}
 
 	/**
 	 * Calculate the poles, P12, P13, P14, P23, P24, P34, and image poles, P23', P24', P34'
 	 */
-	std::vector<std::vector<std::vector<glm::dvec2>>> calculatePoles(const std::vector<glm::dmat4x4>& poses) {
-		// calculate the coordinates of two points on the coupler
-		std::vector<std::vector<glm::dvec2>> points(poses.size());
-		for (int i = 0; i < poses.size(); i++) {
-			glm::dvec2 a(poses[i] * glm::dvec4(0, 0, 0, 1));
-			glm::dvec2 b(poses[i] * glm::dvec4(0.843, 0, 0, 1));
-
-			points[i].push_back(a);
-			points[i].push_back(b);
-		}
-
-		// calculate the coordinates of pole_{i,j}
-		std::vector<std::vector<std::vector<glm::dvec2>>> P(2, std::vector<std::vector<glm::dvec2>>(4, std::vector<glm::dvec2>(4)));
-		int cnt = 0;
-		for (int i = 0; i < points.size() - 1; i++) {
-			for (int j = i + 1; j < points.size(); j++, cnt++) {
-				glm::dvec2 m1 = (points[i][0] + points[j][0]) * 0.5;
-				glm::dvec2 v1 = points[j][0] - points[i][0];
-				glm::dvec2 n1(-v1.y, v1.x);
-				n1 /= glm::length(n1);
-
-				glm::dvec2 m2 = (points[i][1] + points[j][1]) * 0.5;
-				glm::dvec2 v2 = points[j][1] - points[i][1];
-				glm::dvec2 n2(-v2.y, v2.x);
-				n2 /= glm::length(n2);
-
-				glm::dvec2 pole;
-				if (kinematics::lineLineIntersection(m1, n1, m2, n2, pole)) {
-					P[0][i][j] = pole;
-					P[0][j][i] = pole;
-				}
-			}
-		}
-
-		P[1] = P[0];
+	PoseSet<4>::PoleTable calculatePoles(const std::vector<glm::dmat4x4>& poses) {
+		return PoseSet<4>(poses).P;
+	}
 
-		// calculate the image poles, P23', P24', P34'
-		P[1][1][2] = kinematics::reflect(P[0][1][2], P[0][0][1], P[0][0][1] - P[0][0][2]);
-		P[1][1][3] = kinematics::reflect(P[0][1][3], P[0][0][1], P[0][0][1] - P[0][0][3]);
-		P[1][2][3] = kinematics::reflect(P[0][2][3], P[0][0][2], P[0][0][2] - P[0][0][3]);
-		P[1][2][1] = P[1][1][2];
-		P[1][3][1] = P[1][1][3];
-		P[1][3][2] = P[1][2][3];
+	std::vector<std::vector<std::vector<SpecialPoint>>> calculatePoleIntersections(const std::vector<glm::dmat4x4>& poses, const std::vector<CurveSet>& curves) {
+		std::vector<CurveIndex> curve_indices(2);
+		for (int i = 0; i < 2; i++) {
+			curve_indices[i].build(curves[i]);
+		}
 
-		return P;
+		return calculatePoleIntersections(poses, curves, curve_indices);
 	}
 
-	std::vector<std::vector<std::vector<SpecialPoint>>> calculatePoleIntersections(const std::vector<glm::dmat4x4>& poses, const std::vector<std::vector<std::vector<glm::dvec2>>>& curves) {
-		std::vector<std::vector<std::vector<SpecialPoint>>> ans(2, std::vector<std::vector<SpecialPoint>>(curves[0].size()));
+	/**
+	 * Calculate the pole intersections, Q_{ij}, using the spatial indices of the center point curve and the circle point curve.
+	 */
+	std::vector<std::vector<std::vector<SpecialPoint>>> calculatePoleIntersections(const std::vector<glm::dmat4x4>& poses, const std::vector<CurveSet>& curves, const std::vector<CurveIndex>& curve_indices) {
+		return calculatePoleIntersections(calculatePoles(poses), curves, curve_indices);
+	}
 
-		std::vector<std::vector<std::vector<glm::dvec2>>> P = calculatePoles(poses);
+	std::vector<std::vector<std::vector<SpecialPoint>>> calculatePoleIntersections(const PoseSet<4>::PoleTable& P, const std::vector<CurveSet>& curves, const std::vector<CurveIndex>& curve_indices) {
+		std::vector<std::vector<std::vector<SpecialPoint>>> ans(2, std::vector<std::vector<SpecialPoint>>(curves[0].numLoops()));
 
 		for (int i = 0; i < 2; i++) {
 			for (int j = 0; j < 3; j++) {
 				for (int k = j + 1; k < 4; k++) {
-					std::vector<glm::dvec2> p;
+					std::array<glm::dvec2, 4> p;
+					int n = 0;
 					for (int l = 0; l < 4; l++) {
 						if (l == j || l == k) continue;
-						p.push_back(P[i][l][j]);
-						p.push_back(P[i][l][k]);
+						p[n++] = P[i][l][j];
+						p[n++] = P[i][l][k];
 					}
 
 					glm::dvec2 Q;
 					lineLineIntersection(p[0], p[0] - p[1], p[2], p[2] - p[3], Q);
-					std::pair<int, int> indices = findSolution(curves[i], Q);
+					std::pair<int, int> indices = findSolution(curve_indices[i], Q);
+					if (indices.first < 0) continue;
 					ans[i][indices.first].push_back(SpecialPoint(indices.second, SpecialPoint::TYPE_Q, { j, k }));
 				}
 			}
@@ -324,10 +649,12 @@ namespace kinematics {
 	/**
 	 * Given the circle point curve and poles, find Us and Ts.
 	 */
-	std::vector<std::vector<SpecialPoint>> calculateUTs(const std::vector<std::vector<glm::dvec2>>& curve, const std::vector<std::vector<std::vector<glm::dvec2>>>& P) {
-		std::vector<std::vector<SpecialPoint>> ans(curve.size());
+	std::vector<std::vector<SpecialPoint>> calculateUTs(const CurveSet& curve, const PoseSet<4>::PoleTable& P) {
+		std::vector<std::vector<SpecialPoint>> ans(curve.numLoops());
+
+		for (int i = 0; i < curve.numLoops(); i++) {
+			CurveIndex curve_index(curve, i);
 
-		for (int i = 0; i < curve.size(); i++) {
 			for (int j = 0; j < 3; j++) {
 				for (int k = j + 1; k < 4; k++) {
 					int l = 0;
@@ -335,7 +662,7 @@ namespace kinematics {
 						if (l != j && l != k) break;
 					}
 					
-					calculateUT(curve[i], P[1][l][j], P[1][l][k], { j, k }, ans[i]);
+					calculateUT(curve, i, curve_index, P[1][l][j], P[1][l][k], { j, k }, ans[i]);
 				}
 			}
 			std::sort(ans[i].begin(), ans[i].end(), compare);
@@ -345,23 +672,26 @@ namespace kinematics {
 	}
 
 	/**
-	* Given the circle point curve and a pair of poles, find U and T.
+	* Given the loop of the circle point curve and a pair of poles, find U and T.
+	* curve_index is the spatial index of the loop, which is used to find the closest point on the loop.
 	*/
-	void calculateUT(const std::vector<glm::dvec2>& curve, const glm::dvec2& P1, const glm::dvec2& P2, const std::pair<int, int>& subscript, std::vector<SpecialPoint>& ret) {
+	void calculateUT(const CurveSet& curve, int loop, const CurveIndex& curve_index, const glm::dvec2& P1, const glm::dvec2& P2, const std::pair<int, int>& subscript, std::vector<SpecialPoint>& ret) {
 		glm::dvec2 c = (P1 + P2) * 0.5;
 		double r = glm::length(P2 - P1) * 0.5;
 
-		for (int j = 0; j < curve.size() - 1; j++) {
-			if (curve[j] == P1 && curve[j] == P2) continue;
+		for (int j = curve.offsets[loop]; j < curve.offsets[loop + 1] - 1; j++) {
+			glm::dvec2 pt1 = curve.point(j);
+			glm::dvec2 pt2 = curve.point(j + 1);
+			if (pt1 == P1 && pt1 == P2) continue;
 
-			double d1 = glm::length(curve[j] - c);
-			double d2 = glm::length(curve[j + 1] - c);
+			double d1 = glm::length(pt1 - c);
+			double d2 = glm::length(pt2 - c);
 			if ((d1 < r && d2 > r) || (d1 > r && d2 < r)) {
 				double s1 = abs(r - d1);
 				double s2 = abs(r - d2);
-				glm::dvec2 pt = curve[j] + (curve[j + 1] - curve[j]) / (s1 + s2) * s1;
+				glm::dvec2 pt = pt1 + (pt2 - pt1) / (s1 + s2) * s1;
 				if (glm::length(pt - P1) > 0.1 && glm::length(pt - P2) > 0.1) {
-					int index = findSolution(curve, pt);
+					int index = findSolution(curve_index, pt).second;
 
 					ret.push_back(SpecialPoint(index, SpecialPoint::TYPE_UT, subscript));
 				}
@@ -372,28 +702,17 @@ namespace kinematics {
 	/**
 	 * Given a circle point curve, find the solution set that is permissible as the circle point of a driven crank without any branch defect
 	 */
-	std::vector<std::vector<std::tuple<int, int, int>>> findExtremePoses(const std::vector<glm::dmat4x4>& poses, const std::vector<std::vector<glm::dvec2>>& curve, std::vector<std::vector<glm::dvec2>>& P, std::vector<std::vector<SpecialPoint>>& Q, std::vector<std::vector<SpecialPoint>>& UT) {
-		std::vector<std::vector<std::tuple<int, int, int>>> extreme_poses(curve.size());
+	std::vector<std::vector<std::tuple<int, int, int>>> findExtremePoses(const std::vector<glm::dmat4x4>& poses, const CurveSet& curve, const PoseSet<4>::PoleMatrix& P, std::vector<std::vector<SpecialPoint>>& Q, std::vector<std::vector<SpecialPoint>>& UT) {
+		return findExtremePoses(PoseSet<4>(poses).theta, curve, P, Q, UT);
+	}
 
-		// calculate theta_i
-		std::vector<double> theta(4, M_PI);
-		if (poses[0][0][0] != 0.0) {
-			theta[0] = atan2(poses[0][0][1], poses[0][0][0]);
-		}
-		double theta2 = M_PI;
-		if (poses[1][0][0] != 0.0) {
-			theta[1] = atan2(poses[1][0][1], poses[1][0][0]);
-		}
-		double theta3 = M_PI;
-		if (poses[2][0][0] != 0.0) {
-			theta[2] = atan2(poses[2][0][1], poses[2][0][0]);
-		}
-		double theta4 = M_PI;
-		if (poses[3][0][0] != 0.0) {
-			theta[3] = atan2(poses[3][0][1], poses[3][0][0]);
-		}
+	/**
+	 * Given a circle point curve, find the extreme poses using the angles theta_i of the poses.
+	 */
+	std::vector<std::vector<std::tuple<int, int, int>>> findExtremePoses(const std::array<double, 4>& theta, const CurveSet& curve, const PoseSet<4>::PoleMatrix& P, const std::vector<std::vector<SpecialPoint>>& Q, const std::vector<std::vector<SpecialPoint>>& UT) {
+		std::vector<std::vector<std::tuple<int, int, int>>> extreme_poses(curve.numLoops());
 
-		std::vector<std::vector<SpecialPoint>> special_points(curve.size());
+		std::vector<std::vector<SpecialPoint>> special_points(curve.numLoops());
 
 		for (int i = 0; i < Q.size(); i++) {
 			std::vector<SpecialPoint> pts = Q[i];
@@ -402,18 +721,13 @@ namespace kinematics {
 			std::sort(pts.begin(), pts.end(), compare);
 
 			// initialize the sign of the six angles
-			std::vector<std::vector<bool>> table(4, std::vector<bool>(4, false));
-			if (glm::length(curve[i].front() - curve[i].back()) < 10.0) {
+			PoseSet<4>::SignTable table;
+			if (glm::length(curve.front(i) - curve.back(i)) < 10.0) {
 				// initialize the sign based on point B
 				for (int j = 0; j < 4; j++) {
 					for (int k = 0; k < 4; k++) {
 						if (j == k) continue;
-						if (theta[j] > theta[k]) {
-							table[j][k] = true;
-						}
-						else {
-							table[j][k] = false;
-						}
+						table.set(j, k, theta[j] > theta[k]);
 					}
 				}
 			}
@@ -428,13 +742,8 @@ namespace kinematics {
 						}
 
 						glm::dvec2 v1 = P[l][k] - P[l][j];
-						glm::dvec2 v2 = curve[i].front() - P[l][j];
-						if (v1.x * v2.y - v1.y * v2.x >= 0) {
-							table[j][k] = true;
-						}
-						else {
-							table[j][k] = false;
-						}
+						glm::dvec2 v2 = curve.front(i) - P[l][j];
+						table.set(j, k, v1.x * v2.y - v1.y * v2.x >= 0);
 					}
 				}
 			}
@@ -444,7 +753,7 @@ namespace kinematics {
 			extreme_poses[i].push_back(std::make_tuple(0, ep.first, ep.second));
 
 			for (int j = 0; j < pts.size(); j++) {
-				std::swap(table[pts[j].subscript.first][pts[j].subscript.second], table[pts[j].subscript.second][pts[j].subscript.first]);
+				table.swap(pts[j].subscript.first, pts[j].subscript.second);
 				std::pair<int, int> ep = findExtremePoses(table);
 				extreme_poses[i].push_back(std::make_tuple(pts[j].index, ep.first, ep.second));
 			}
@@ -453,51 +762,37 @@ namespace kinematics {
 		return extreme_poses;
 	}
 
-	std::pair<int, int> findExtremePoses(const std::vector<std::vector<bool>>& table) {
-		int pose1 = -1;
-		int pose2 = -1;
-		for (int j = 0; j < 4; j++) {
-			bool extreme = true;
-			for (int k = 0; k < 4; k++) {
-				if (j == k) continue;
-				if (!table[j][k]) {
-					extreme = false;
-					break;
-				}
-			}
-
-			if (extreme) {
-				pose1 = j;
-				break;
+	/**
+	 * The extreme poses of all the 4096 sign tables of four poses, indexed by the key of the table.
+	 */
+	class ExtremePoseLookupTable {
+	public:
+		std::vector<std::pair<int, int>> entries;
+
+	public:
+		ExtremePoseLookupTable() : entries(1 << 12) {
+			for (unsigned long key = 0; key < entries.size(); key++) {
+				entries[key] = PoseSet<4>::SignTable(key).findExtremePoses();
 			}
 		}
+	};
 
-		for (int j = 0; j < 4; j++) {
-			bool extreme = true;
-			for (int k = 0; k < 4; k++) {
-				if (j == k) continue;
-				if (!table[k][j]) {
-					extreme = false;
-					break;
-				}
-			}
-
-			if (extreme) {
-				pose2 = j;
-				break;
-			}
-		}
+	static const ExtremePoseLookupTable extreme_pose_lookup_table;
 
-		return std::make_pair(pose1, pose2);
+	/**
+	 * Return the first pose whose row of the sign table is all true and the first pose whose column is all true by the lookup table.
+	 */
+	std::pair<int, int> findExtremePoses(const PoseSet<4>::SignTable& table) {
+		return extreme_pose_lookup_table.entries[table.key()];
 	}
 
-	std::pair<int, int> findSolution(const std::vector<std::vector<glm::dvec2>>& curves, const glm::dvec2& pt) {
+	std::pair<int, int> findSolution(const CurveSet& curves, const glm::dvec2& pt) {
 		std::pair<int, int> ans = { -1, -1 };
 
 		double min_dist = std::numeric_limits<double>::max();
-		for (int i = 0; i < curves.size(); i++) {
-			for (int j = 0; j < curves[i].size(); j++) {
-				double dist = glm::length(curves[i][j] - pt);
+		for (int i = 0; i < curves.numLoops(); i++) {
+			for (int j = 0; j < curves.size(i); j++) {
+				double dist = glm::length(curves.point(i, j) - pt);
 				if (dist < min_dist) {
 					min_dist = dist;
 					ans = { i, j };
@@ -508,12 +803,12 @@ namespace kinematics {
 		return ans;
 	}
 
-	int findSolution(const std::vector<glm::dvec2>& curve, const glm::dvec2& pt) {
+	int findSolution(const CurveSet& curves, int loop, const glm::dvec2& pt) {
 		int ans = -1;
 
 		double min_dist = std::numeric_limits<double>::max();
-		for (int i = 0; i < curve.size(); i++) {
-			double dist = glm::length(curve[i] - pt);
+		for (int i = 0; i < curves.size(loop); i++) {
+			double dist = glm::length(curves.point(loop, i) - pt);
 			if (dist < min_dist) {
 				min_dist = dist;
 				ans = i;
@@ -523,52 +818,231 @@ namespace kinematics {
 		return ans;
 	}
 
-	std::vector<std::vector<glm::dvec2>> findValidSolution(const std::vector<glm::dmat4x4>& poses, const std::vector<std::vector<std::vector<glm::dvec2>>>& curves) {
-		std::map<double, std::tuple<glm::dvec2, glm::dvec2, glm::dvec2, glm::dvec2>> solutions;
+	/**
+	 * Find the closest point on the curves using the spatial index.
+	 */
+	std::pair<int, int> findSolution(const CurveIndex& curve_index, const glm::dvec2& pt) {
+		return curve_index.findNearest(pt);
+	}
+
+	/**
+	 * Return the lower bound of the total link length g + a + b + h of a four-bar linkage whose crank lengths are a and b.
+	 * Since any link is not longer than the sum of the others, the total length is at least 2 * max(a, b).
+	 * Also, g and h are at least 0.5 for a valid solution.
+	 */
+	double lowerBoundOfLength(double a, double b) {
+		return std::max(std::max(a, b) * 2.0, a + b + 1.0);
+	}
+
+	/**
+	 * Add the candidate if it is one of the best max_solutions candidates.
+	 * Return true if it is added.
+	 */
+	bool SolutionRanking::add(const SolutionCandidate& candidate) {
+		auto worse = [](const SolutionCandidate& s1, const SolutionCandidate& s2) { return s1.isBetterThan(s2); };
+
+		if (max_solutions <= 0) {
+			candidates.push_back(candidate);
+			return true;
+		}
+
+		if (candidates.size() < max_solutions) {
+			candidates.push_back(candidate);
+			std::push_heap(candidates.begin(), candidates.end(), worse);
+			return true;
+		}
+
+		if (!candidate.isBetterThan(candidates.front())) return false;
+
+		std::pop_heap(candidates.begin(), candidates.end(), worse);
+		candidates.back() = candidate;
+		std::push_heap(candidates.begin(), candidates.end(), worse);
+		return true;
+	}
+
+	void SolutionRanking::merge(const SolutionRanking& ranking) {
+		for (int i = 0; i < ranking.candidates.size(); i++) {
+			add(ranking.candidates[i]);
+		}
+	}
+
+	/**
+	 * Return the candidates from the best to the worst.
+	 */
+	std::vector<SolutionCandidate> SolutionRanking::sorted() const {
+		std::vector<SolutionCandidate> ans = candidates;
+		std::sort(ans.begin(), ans.end(), [](const SolutionCandidate& s1, const SolutionCandidate& s2) { return s1.isBetterThan(s2); });
+		return ans;
+	}
+
+	/**
+	 * Find the valid solution that has the minimum total link length.
+	 * The result is {{C1, C2}, {X1, X2}}, which are all zero if no solution was found.
+	 */
+	std::vector<std::vector<glm::dvec2>> findValidSolution(const std::vector<glm::dmat4x4>& poses, const std::vector<CurveSet>& curves, int num_threads) {
+		std::vector<SolutionCandidate> solutions = findValidSolutions(poses, curves, SolutionSearchParams(1, false, num_threads));
 
-		for (int i = 0; i < curves[0].size(); i++) {
-			for (int j = 0; j < curves[0][i].size(); j++) {
-				for (int k = 0; k < curves[0].size(); k++) {
-					for (int l = 0; l < curves[0][k].size(); l++) {
-						if (i == k && j == l) continue;
+		std::vector<std::vector<glm::dvec2>> ans(2, std::vector<glm::dvec2>(2));
+		if (solutions.size() > 0) {
+			ans[0][0] = solutions[0].C1;
+			ans[1][0] = solutions[0].X1;
+			ans[0][1] = solutions[0].C2;
+			ans[1][1] = solutions[0].X2;
+		}
+
+		return ans;
+	}
+
+	/**
+	 * Find the valid solutions, and return the best params.max_solutions of them in the increasing order of the total link length.
+	 * The pairs of the input crank and the follower crank are distributed over params.num_threads threads
+	 * (the number of hardware threads if it is 0). Each thread keeps its own ranking,
+	 * and they are merged in the same order as the serial search, so the result does not depend on the number of threads.
+	 * The cranks are examined in the increasing order of their length, and the pairs whose lower bound of the total
+	 * link length exceeds the worst of the best solutions found so far are skipped before running the defect checks.
+	 * If the search is cancelled or exceeds params.time_limit, the best solutions found so far are returned,
+	 * and completed is set to false, so that the truncated result is not taken for the complete one (e.g., by the cache).
+	 */
+	std::vector<SolutionCandidate> findValidSolutions(const std::vector<glm::dmat4x4>& poses, const std::vector<CurveSet>& curves, const SolutionSearchParams& params) {
+		return findValidSolutions(PoseSet<4>(poses), curves, params);
+	}
+
+	std::vector<SolutionCandidate> findValidSolutions(const PoseSet<4>& pose_set, const std::vector<CurveSet>& curves, const SolutionSearchParams& params) {
+		bool completed;
+		return findValidSolutions(pose_set, curves, params, completed);
+	}
+
+	std::vector<SolutionCandidate> findValidSolutions(const PoseSet<4>& pose_set, const std::vector<CurveSet>& curves, const SolutionSearchParams& params, bool& completed) {
+		int N = curves[0].numPoints();
+
+		// precompute the cranks of all the curve points
+		std::vector<CrankContext> cranks(N);
+		for (int p = 0; p < N; p++) {
+			cranks[p] = CrankContext(pose_set, curves[0].point(p), curves[1].point(p));
+		}
+
+		// sort the cranks by their length so that the pairs of short cranks are examined first
+		std::vector<int> sorted(N);
+		for (int p = 0; p < N; p++) sorted[p] = p;
+		std::sort(sorted.begin(), sorted.end(), [&cranks](int p1, int p2) { return cranks[p1].length < cranks[p2].length; });
+
+		int num_threads = params.num_threads;
+		if (num_threads <= 0) num_threads = std::max(1, (int)std::thread::hardware_concurrency());
+		num_threads = std::min(num_threads, std::max(1, N));
+
+		// The worst of the best solutions of any thread is an upper bound of the total link length of the best solutions.
+		std::atomic<double> bound(std::numeric_limits<double>::max());
+
+		std::mutex callback_mutex;
+
+		// the search is interrupted when it is cancelled or the time limit is exceeded
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(params.time_limit));
+		std::atomic<bool> interrupted(false);
+		auto isInterrupted = [&]() {
+			if (interrupted.load(std::memory_order_relaxed)) return true;
+			if ((params.cancelled != NULL && params.cancelled->load()) || (params.time_limit > 0 && std::chrono::steady_clock::now() > deadline)) {
+				interrupted = true;
+			}
+			return interrupted.load(std::memory_order_relaxed);
+		};
+
+		// the number of pairs that have been examined or pruned
+		long long num_pairs = (long long)N * (N - 1);
+		std::atomic<long long> num_examined(0);
+
+		// the threads take the next chunk of the input cranks from the shared counter
+		const int chunk_size = 16;
+		std::atomic<int> next_chunk(0);
+		std::vector<SolutionRanking> rankings(num_threads, SolutionRanking(params.max_solutions));
+		auto worker = [&](int thread_id) {
+			for (int start = next_chunk.fetch_add(chunk_size); start < N; start = next_chunk.fetch_add(chunk_size)) {
+				int end = std::min(start + chunk_size, N);
+				for (int sp = start; sp < end; sp++) {
+					if (isInterrupted()) return;
+
+					int p = sorted[sp];
+					if (cranks[p].order_defect && !params.allow_defects) continue;
+
+					// the bound increases with the length of the follower crank, so the remaining pairs can be skipped once it exceeds the best one
+					if (lowerBoundOfLength(cranks[p].length, cranks[sorted[0]].length) > bound.load(std::memory_order_relaxed)) break;
+
+					for (int sq = 0; sq < N; sq++) {
+						int q = sorted[sq];
+						if (p == q) continue;
+						if (lowerBoundOfLength(cranks[p].length, cranks[q].length) > bound.load(std::memory_order_relaxed)) break;
 
 						// get the coordinates of the input crank
-						glm::dvec2 C1 = curves[0][i][j];
-						glm::dvec2 X1 = curves[1][i][j];
+						const glm::dvec2& C1 = cranks[p].C;
+						const glm::dvec2& X1 = cranks[p].X;
 
 						// get the coordinates of the follower crank
-						glm::dvec2 C2 = curves[0][k][l];
-						glm::dvec2 X2 = curves[1][k][l];
+						const glm::dvec2& C2 = cranks[q].C;
+						const glm::dvec2& X2 = cranks[q].X;
 
 						double g = glm::length(C1 - C2);
-						double a = glm::length(X1 - C1);
-						double b = glm::length(X2 - C2);
+						double a = cranks[p].length;
+						double b = cranks[q].length;
 						double h = glm::length(X1 - X2);
 						if (g < 0.5 || a < 0.5 || b < 0.5 || h < 0.5) continue;
 
-						if (checkGrashofDefect(C1, C2, X1, X2)) continue;
-						if (checkOrderDefect(poses, C1, C2, X1, X2)) continue;
-						if (checkBranchDefect(poses, C1, C2, X1, X2)) continue;
+						// A pair that is longer than the bound cannot be one of the best solutions.
+						// A pair of the same length is still examined because it may win the tie.
+						double length = g + a + b + h;
+						if (length > bound.load(std::memory_order_relaxed)) continue;
 
-						solutions[g + a + b + h] = std::make_tuple(C1, C2, X1, X2);
+						SolutionCandidate candidate(length, (long long)p * N + q, C1, C2, X1, X2);
+						candidate.grashof_type = getGrashofType(C1, C2, X1, X2);
+						candidate.grashof_defect = candidate.grashof_type != 0 && candidate.grashof_type != 1;
+						if (candidate.grashof_defect && !params.allow_defects) continue;
+						candidate.order_defect = cranks[p].order_defect;
+						candidate.branch_defect = checkBranchDefect(cranks[p], cranks[q], candidate.grashof_type);
+						if (candidate.branch_defect && !params.allow_defects) continue;
+
+						if (!rankings[thread_id].add(candidate)) continue;
+
+						if (params.callback) {
+							std::lock_guard<std::mutex> lock(callback_mutex);
+							params.callback(candidate);
+						}
+
+						if (rankings[thread_id].isFull()) {
+							double worst_length = rankings[thread_id].worst().length;
+							double current = bound.load();
+							while (worst_length < current && !bound.compare_exchange_weak(current, worst_length)) {}
+						}
 					}
 				}
+
+				// the pairs of this chunk have been examined or pruned
+				long long examined = num_examined.fetch_add((long long)(end - start) * (N - 1)) + (long long)(end - start) * (N - 1);
+				if (params.progress) {
+					std::lock_guard<std::mutex> lock(callback_mutex);
+					params.progress(examined, num_pairs);
+				}
 			}
-		}
+		};
 
-		std::vector<std::vector<glm::dvec2>> ans(2, std::vector<glm::dvec2>(2));
-		if (solutions.size() == 0) {
-			std::cout << "No solution was found." << std::endl;
+		if (num_threads == 1) {
+			worker(0);
 		}
 		else {
-			auto it = solutions.begin();
-			ans[0][0] = std::get<0>(it->second);
-			ans[1][0] = std::get<2>(it->second);
-			ans[0][1] = std::get<1>(it->second);
-			ans[1][1] = std::get<3>(it->second);
+			std::vector<std::thread> threads;
+			for (int i = 0; i < num_threads; i++) {
+				threads.push_back(std::thread(worker, i));
+			}
+			for (int i = 0; i < num_threads; i++) {
+				threads[i].join();
+			}
 		}
 
-		return ans;
+		// merge the rankings of the threads
+		SolutionRanking ranking(params.max_solutions);
+		for (int i = 0; i < num_threads; i++) {
+			ranking.merge(rankings[i]);
+		}
+
+		completed = !interrupted;
+		return ranking.sorted();
 	}
 
 	/**
@@ -640,43 +1114,53 @@ namespace kinematics {
 		}
 	}
 
+	/**
+	 * Precompute the coordinates of the circle point X in the moving frame, its world coordinates in each pose,
+	 * and the angle of the crank C-X in each pose, so that they can be shared by all the pairs that use this crank.
+	 */
+	CrankContext::CrankContext(const PoseSet<4>& pose_set, const glm::dvec2& C, const glm::dvec2& X) : C(C), X(X) {
+		length = glm::length(X - C);
+		inv_W = glm::dvec2(glm::inverse(pose_set.poses[0]) * glm::dvec4(X, 0, 1));
+
+		for (int i = 0; i < 4; i++) {
+			// calculate the coordinates of the circle point in the world coordinate system
+			X_poses[i] = glm::dvec2(pose_set.poses[i] * glm::dvec4(inv_W, 0, 1));
+
+			// calculate the angle of the direction from the ground pivot (center point) to the circle point
+			glm::dvec2 dir = X_poses[i] - C;
+			angles[i] = atan2(dir.y, dir.x);
+		}
+
+		order_defect = checkOrderDefect(*this);
+	}
+
 	/**
 	* Check if the linkage has order defect.
 	* If there is an order defect, true is returned.
 	* Otherwise, false is returned.
 	*/
 	bool checkOrderDefect(const std::vector<glm::dmat4x4>& poses, const glm::dvec2& C1, const glm::dvec2& C2, const glm::dvec2& X1, const glm::dvec2& X2) {
-		int linkage_type = getGrashofType(C1, C2, X1, X2);
-
-		glm::dvec2 inv_W = glm::dvec2(glm::inverse(poses[0]) * glm::dvec4(X1, 0, 1));
+		return CrankContext(PoseSet<4>(poses), C1, X1).order_defect;
+	}
 
+	/**
+	* Check if the driving crank has order defect.
+	* The order defect depends only on the driving crank, so it is computed once per crank.
+	*/
+	bool checkOrderDefect(const CrankContext& crank) {
 		double total_cw = 0;
 		double total_ccw = 0;
-		double prev = 0;
-		//int ccw = 1;
-		for (int i = 0; i < poses.size(); i++) {
-			// calculate the coordinates of the circle point of the driving crank in the world coordinate system
-			glm::dvec2 X = glm::dvec2(poses[i] * glm::dvec4(inv_W, 0, 1));
-			//std::cout << X.x << "," << X.y << std::endl;
-
-			// calculate the direction from the ground pivot (center point) of the driving crank to the circle point
-			glm::dvec2 dir = X - C1;
-
-			// calculate its angle
-			double theta = atan2(dir.y, dir.x);
-
-			if (i >= 1) {
-				if (theta >= prev) {
-					total_cw += kinematics::M_PI * 2 - theta + prev;
-					total_ccw += theta - prev;
-				}
-				else {
-					total_cw += prev - theta;
-					total_ccw += kinematics::M_PI * 2 - prev + theta;
-				}
+		for (int i = 1; i < crank.angles.size(); i++) {
+			double prev = crank.angles[i - 1];
+			double theta = crank.angles[i];
+			if (theta >= prev) {
+				total_cw += kinematics::M_PI * 2 - theta + prev;
+				total_ccw += theta - prev;
+			}
+			else {
+				total_cw += prev - theta;
+				total_ccw += kinematics::M_PI * 2 - prev + theta;
 			}
-
-			prev = theta;
 		}
 
 		if (total_cw > kinematics::M_PI * 2 + 0.1 && total_ccw > kinematics::M_PI * 2 + 0.1) return true;
@@ -689,19 +1173,25 @@ namespace kinematics {
 	* Otherwise, false is returned.
 	*/
 	bool checkBranchDefect(const std::vector<glm::dmat4x4>& poses, const glm::dvec2& C1, const glm::dvec2& C2, const glm::dvec2& X1, const glm::dvec2& X2) {
-		int type = getGrashofType(C1, C2, X1, X2);
+		PoseSet<4> pose_set(poses);
+		return checkBranchDefect(CrankContext(pose_set, C1, X1), CrankContext(pose_set, C2, X2), getGrashofType(C1, C2, X1, X2));
+	}
+
+	/**
+	* Check if all the poses are in the same branch using the precomputed cranks.
+	* type is the Grashof type of the linkage.
+	*/
+	bool checkBranchDefect(const CrankContext& crank1, const CrankContext& crank2, int type) {
+		const glm::dvec2& C1 = crank1.C;
+		const glm::dvec2& C2 = crank2.C;
 
 		if (type == 0) {	// Grashof (Drag-link)
 			int sign1 = 1;
 			int sign2 = 1;
 
-			glm::dvec2 inv_W1 = glm::dvec2(glm::inverse(poses[0]) * glm::dvec4(X1, 0, 1));
-			glm::dvec2 inv_W2 = glm::dvec2(glm::inverse(poses[0]) * glm::dvec4(X2, 0, 1));
-
-			for (int i = 0; i < poses.size(); i++) {
-				// calculate the coordinates of the circle point of the driving/driven cranks in the world coordinate system
-				glm::dvec2 X1 = glm::dvec2(poses[i] * glm::dvec4(inv_W1, 0, 1));
-				glm::dvec2 X2 = glm::dvec2(poses[i] * glm::dvec4(inv_W2, 0, 1));
+			for (int i = 0; i < crank1.X_poses.size(); i++) {
+				const glm::dvec2& X1 = crank1.X_poses[i];
+				const glm::dvec2& X2 = crank2.X_poses[i];
 
 				// calculate the direction from the ground pivot (center point) of the driving crank to the circle point
 				glm::dvec2 v1 = X1 - C1;
@@ -718,11 +1208,6 @@ namespace kinematics {
 					sign2 = (v2.x * v3.y - v2.y * v3.x >= 0) ? 1 : -1;
 				}
 				else {
-					/*
-					if ((v1.x * v3.y - v1.y * v3.x >= 0 ? 1 : -1) != sign1) sign1 = 9999;
-					if ((v2.x * v3.y - v2.y * v3.x >= 0 ? 1 : -1) != sign2) sign2 = 9999;
-					if (sign1 == 9999 && sign2 == 9999) return true;
-					*/
 					if ((v1.x * v3.y - v1.y * v3.x >= 0 ? 1 : -1) != sign1) return true;
 					if ((v2.x * v3.y - v2.y * v3.x >= 0 ? 1 : -1) != sign2) return true;
 				}
@@ -733,13 +1218,9 @@ namespace kinematics {
 		else if (type == 1) {	// Grashof (Crank-rocker)
 			int sign = 1;
 
-			glm::dvec2 inv_W1 = glm::dvec2(glm::inverse(poses[0]) * glm::dvec4(X1, 0, 1));
-			glm::dvec2 inv_W2 = glm::dvec2(glm::inverse(poses[0]) * glm::dvec4(X2, 0, 1));
-
-			for (int i = 0; i < poses.size(); i++) {
-				// calculate the coordinates of the circle point of the driving/driven cranks in the world coordinate system
-				glm::dvec2 X1 = glm::dvec2(poses[i] * glm::dvec4(inv_W1, 0, 1));
-				glm::dvec2 X2 = glm::dvec2(poses[i] * glm::dvec4(inv_W2, 0, 1));
+			for (int i = 0; i < crank1.X_poses.size(); i++) {
+				const glm::dvec2& X1 = crank1.X_poses[i];
+				const glm::dvec2& X2 = crank2.X_poses[i];
 
 				// calculate the direction from the ground pivot (center point) of the driven crank to the circle point
 				glm::dvec2 v1 = X2 - C2;
@@ -762,13 +1243,9 @@ namespace kinematics {
 			int sign1 = 1;
 			int sign2 = 1;
 
-			glm::dvec2 inv_W1 = glm::dvec2(glm::inverse(poses[0]) * glm::dvec4(X1, 0, 1));
-			glm::dvec2 inv_W2 = glm::dvec2(glm::inverse(poses[0]) * glm::dvec4(X2, 0, 1));
-
-			for (int i = 0; i < poses.size(); i++) {
-				// calculate the coordinates of the circle point of the driving/driven cranks in the world coordinate system
-				glm::dvec2 X1 = glm::dvec2(poses[i] * glm::dvec4(inv_W1, 0, 1));
-				glm::dvec2 X2 = glm::dvec2(poses[i] * glm::dvec4(inv_W2, 0, 1));
+			for (int i = 0; i < crank1.X_poses.size(); i++) {
+				const glm::dvec2& X1 = crank1.X_poses[i];
+				const glm::dvec2& X2 = crank2.X_poses[i];
 
 				// calculate the direction from the ground pivot (center point) of the driving crank to the circle point
 				glm::dvec2 v1 = X1 - C1;
@@ -796,13 +1273,9 @@ namespace kinematics {
 			int sign1 = 1;
 			int sign2 = 1;
 
-			glm::dvec2 inv_W1 = glm::dvec2(glm::inverse(poses[0]) * glm::dvec4(X1, 0, 1));
-			glm::dvec2 inv_W2 = glm::dvec2(glm::inverse(poses[0]) * glm::dvec4(X2, 0, 1));
-
-			for (int i = 0; i < poses.size(); i++) {
-				// calculate the coordinates of the circle point of the driving/driven cranks in the world coordinate system
-				glm::dvec2 X1 = glm::dvec2(poses[i] * glm::dvec4(inv_W1, 0, 1));
-				glm::dvec2 X2 = glm::dvec2(poses[i] * glm::dvec4(inv_W2, 0, 1));
+			for (int i = 0; i < crank1.X_poses.size(); i++) {
+				const glm::dvec2& X1 = crank1.X_poses[i];
+				const glm::dvec2& X2 = crank2.X_poses[i];
 
 				// calculate the direction from the ground pivot (center point) of the driving crank to the circle point
 				glm::dvec2 v1 = X1 - C1;
@@ -829,4 +1302,4 @@ namespace kinematics {
 		}
 	}
 
-}
\ No newline at end of file
+}
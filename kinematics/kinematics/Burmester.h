@@ -2,7 +2,13 @@
 
 #include <vector>
 #include <map>
+#include <limits>
+#include <functional>
+#include <atomic>
 #include <glm/glm.hpp>
+#include "CurveSet.h"
+#include "CurveIndex.h"
+#include "PoseSet.h"
 
 namespace kinematics {
 
@@ -18,43 +24,224 @@ namespace kinematics {
 		SpecialPoint(int index, int type, const std::pair<int, int>& subscript) : index(index), type(type), subscript(subscript) {}
 	};
 
-	class Curve {
+	/**
+	 * Parameters of the adaptive sampling of the center point curve.
+	 * tolerance is the maximum chord error of the polyline, and max_spacing is the maximum distance between
+	 * consecutive points. The step of alpha is refined from max_step down to min_step until both are satisfied.
+	 * The intervals where the circles do not intersect at both ends are probed down to probe_step,
+	 * so that a loop whose range of alpha is narrower than max_step is not missed.
+	 * Only the points within max_radius from the centroid of the poles are considered for the refinement.
+	 * The loops whose end points are within stitch_distance are merged into one loop.
+	 * The sweep of alpha is partitioned over num_threads threads (the number of hardware threads if it is 0),
+	 * which pays off only for a high resolution curve, so it is not parallelized by default.
+	 */
+	class CurveSamplingParams {
 	public:
-		bool closed;
-		std::vector<glm::dvec2> points;
+		double tolerance;
+		double max_spacing;
+		double min_step;
+		double max_step;
+		double probe_step;
+		double max_radius;
+		double stitch_distance;
+		int num_threads;
 
 	public:
-		Curve() : closed(false) {}
+		CurveSamplingParams(double tolerance = 0.01, double max_spacing = 0.5, double min_step = 0.0001, double max_step = 0.05, double probe_step = 0.001, double max_radius = 20.0, double stitch_distance = 0.1, int num_threads = 1) : tolerance(tolerance), max_spacing(max_spacing), min_step(min_step), max_step(max_step), probe_step(probe_step), max_radius(max_radius), stitch_distance(stitch_distance), num_threads(num_threads) {}
 	};
 
-	class SolutionSet {
+	/**
+	 * The center points and the corresponding circle points for one value of alpha.
+	 * valid is false if the circles do not intersect for this alpha.
+	 */
+	class CurveSample {
 	public:
-		std::vector<Curve> curves;
+		double alpha;
+		bool valid;
+		glm::dvec2 center_pts[2];
+		glm::dvec2 circle_pts[2];
 
 	public:
-		SolutionSet() {}
+		CurveSample() : alpha(0), valid(false) {}
+	};
+
+	/**
+	 * The center points and the corresponding circle points for a block of alpha values in SoA buffers.
+	 * valid is the feasibility mask, which is 0 where the circles do not intersect or the circle point does not exist.
+	 */
+	class CurveSampleBlock {
+	public:
+		std::vector<double> alpha;
+		std::vector<unsigned char> valid;
+		std::vector<double> center_x[2];
+		std::vector<double> center_y[2];
+		std::vector<double> circle_x[2];
+		std::vector<double> circle_y[2];
+
+	public:
+		CurveSampleBlock() {}
+
+		int size() const { return alpha.size(); }
+		void resize(int n);
+		CurveSample sample(int i) const;
+	};
+
+	/**
+	 * A pair of the input crank and the follower crank.
+	 * order is the position of the pair in the serial search order, and it is -1 if no pair has been found.
+	 * When two pairs have the same total link length, the one that comes later in the serial search is ranked higher.
+	 */
+	class SolutionCandidate {
+	public:
+		double length;
+		long long order;
+		glm::dvec2 C1;
+		glm::dvec2 C2;
+		glm::dvec2 X1;
+		glm::dvec2 X2;
+		int grashof_type;
+		bool grashof_defect;
+		bool order_defect;
+		bool branch_defect;
+
+	public:
+		SolutionCandidate() : length(std::numeric_limits<double>::max()), order(-1), grashof_type(-1), grashof_defect(false), order_defect(false), branch_defect(false) {}
+		SolutionCandidate(double length, long long order, const glm::dvec2& C1, const glm::dvec2& C2, const glm::dvec2& X1, const glm::dvec2& X2) : length(length), order(order), C1(C1), C2(C2), X1(X1), X2(X2), grashof_type(-1), grashof_defect(false), order_defect(false), branch_defect(false) {}
+
+		bool isBetterThan(const SolutionCandidate& other) const {
+			if (other.order < 0) return order >= 0;
+			if (order < 0) return false;
+			return length < other.length || (length == other.length && order > other.order);
+		}
+
+		void update(const SolutionCandidate& candidate) {
+			if (candidate.isBetterThan(*this)) {
+				*this = candidate;
+			}
+		}
+	};
+
+	/**
+	 * The best max_solutions candidates found so far, or all of them if max_solutions is 0.
+	 * The candidates are kept in a heap whose front is the worst one.
+	 */
+	class SolutionRanking {
+	public:
+		int max_solutions;
+		std::vector<SolutionCandidate> candidates;
+
+	public:
+		SolutionRanking(int max_solutions = 0) : max_solutions(max_solutions) {}
+
+		bool add(const SolutionCandidate& candidate);
+		void merge(const SolutionRanking& ranking);
+		bool isFull() const { return max_solutions > 0 && candidates.size() >= max_solutions; }
+		const SolutionCandidate& worst() const { return candidates.front(); }
+		std::vector<SolutionCandidate> sorted() const;
+	};
+
+	/**
+	 * Parameters of the solution search.
+	 * max_solutions is the number of the best solutions to return (0 means all the valid solutions).
+	 * If allow_defects is true, the pairs with defects are also returned with their defect flags.
+	 * callback is called for every solution as soon as it is found (possibly from multiple threads, but never concurrently).
+	 * Since the pairs that cannot be in the best max_solutions are pruned, only a subset of the solutions may be reported unless max_solutions is 0.
+	 * time_limit is the time budget in seconds (0 means no limit), and the search is also interrupted when *cancelled becomes true.
+	 * progress is called with the number of the pairs examined so far and the total number of the pairs.
+	 * The search was completed if the last progress report has the two numbers equal.
+	 */
+	class SolutionSearchParams {
+	public:
+		int max_solutions;
+		bool allow_defects;
+		int num_threads;
+		double time_limit;
+		const std::atomic<bool>* cancelled;
+		std::function<void(const SolutionCandidate&)> callback;
+		std::function<void(long long, long long)> progress;
+
+	public:
+		SolutionSearchParams(int max_solutions = 1, bool allow_defects = false, int num_threads = 0, double time_limit = 0) : max_solutions(max_solutions), allow_defects(allow_defects), num_threads(num_threads), time_limit(time_limit), cancelled(NULL) {}
+	};
+
+	/**
+	 * The precomputed crank of a curve point, i.e., the coordinates of the circle point in the moving frame,
+	 * its world coordinates and the crank angle in each pose, and whether it has order defect as a driving crank.
+	 */
+	class CrankContext {
+	public:
+		glm::dvec2 C;
+		glm::dvec2 X;
+		double length;
+		glm::dvec2 inv_W;
+		std::array<glm::dvec2, 4> X_poses;
+		std::array<double, 4> angles;
+		bool order_defect;
+
+	public:
+		CrankContext() : length(0), order_defect(false) {}
+		CrankContext(const PoseSet<4>& pose_set, const glm::dvec2& C, const glm::dvec2& X);
+	};
+
+	class CenterPointCurveSampler {
+	public:
+		glm::dvec2 P12;
+		glm::dvec2 P13;
+		glm::dvec2 P14;
+		glm::dvec2 P24;
+		glm::dvec2 m1;
+		glm::dvec2 m2;
+		glm::dvec2 v1;
+		glm::dvec2 v2;
+		glm::dvec2 h1;
+		glm::dvec2 h2;
+		glm::dvec2 center;
+		double theta12;
+		double theta13;
+		CurveSamplingParams params;
+
+	public:
+		CenterPointCurveSampler(const glm::dvec2& P12, const glm::dvec2& P13, const glm::dvec2& P14, const glm::dvec2& P23, const glm::dvec2& P24, double theta12, double theta13, const CurveSamplingParams& params);
+
+		CurveSample evaluate(double alpha) const;
+		void evaluate(CurveSampleBlock& block) const;
+		bool isAccurate(const CurveSample& s0, const CurveSample& mid, const CurveSample& s1) const;
+		void refine(std::vector<CurveSample>& samples) const;
 	};
 
 
-	void calculateSolutionCurve(const std::vector<glm::dmat4x4>& poses, std::vector<std::vector<std::vector<glm::dvec2>>>& solutions);
-	std::vector<std::vector<std::vector<glm::dvec2>>> calculateCenterPointCurve(const glm::dvec2& P12, const glm::dvec2& P13, const glm::dvec2& P14, const glm::dvec2& P23, const glm::dvec2& P24, double theta12, double theta13);
+	void calculateSolutionCurve(const std::vector<glm::dmat4x4>& poses, std::vector<CurveSet>& solutions, const CurveSamplingParams& params = CurveSamplingParams());
+	void calculateSolutionCurve(const PoseSet<4>& pose_set, std::vector<CurveSet>& solutions, const CurveSamplingParams& params = CurveSamplingParams());
+	std::vector<CurveSet> calculateCenterPointCurve(const glm::dvec2& P12, const glm::dvec2& P13, const glm::dvec2& P14, const glm::dvec2& P23, const glm::dvec2& P24, double theta12, double theta13, const CurveSamplingParams& params = CurveSamplingParams());
+	std::vector<std::vector<int>> stitchLoops(const CurveSet& loops, double max_dist);
 	glm::dvec2 calculateCirclePointFromCenterPoint(const glm::dvec2& C, const glm::dvec2& P12, const glm::dvec2& P13, double theta12, double theta13);
+	bool calculateCirclePointFromCenterPoint(const glm::dvec2& C, const glm::dvec2& P12, const glm::dvec2& P13, double theta12, double theta13, glm::dvec2& circle_pt);
 
-	std::vector<std::vector<std::vector<glm::dvec2>>> calculatePoles(const std::vector<glm::dmat4x4>& poses);
-	std::vector<std::vector<std::vector<SpecialPoint>>> calculatePoleIntersections(const std::vector<glm::dmat4x4>& poses, const std::vector<std::vector<std::vector<glm::dvec2>>>& curves);
+	PoseSet<4>::PoleTable calculatePoles(const std::vector<glm::dmat4x4>& poses);
+	std::vector<std::vector<std::vector<SpecialPoint>>> calculatePoleIntersections(const std::vector<glm::dmat4x4>& poses, const std::vector<CurveSet>& curves);
+	std::vector<std::vector<std::vector<SpecialPoint>>> calculatePoleIntersections(const std::vector<glm::dmat4x4>& poses, const std::vector<CurveSet>& curves, const std::vector<CurveIndex>& curve_indices);
+	std::vector<std::vector<std::vector<SpecialPoint>>> calculatePoleIntersections(const PoseSet<4>::PoleTable& P, const std::vector<CurveSet>& curves, const std::vector<CurveIndex>& curve_indices);
 
-	std::vector<std::vector<SpecialPoint>> calculateUTs(const std::vector<std::vector<glm::dvec2>>& curve, const std::vector<std::vector<std::vector<glm::dvec2>>>& P);
-	void calculateUT(const std::vector<glm::dvec2>& curve, const glm::dvec2& P1, const glm::dvec2& P2, const std::pair<int, int>& subscript, std::vector<SpecialPoint>& ret);
+	std::vector<std::vector<SpecialPoint>> calculateUTs(const CurveSet& curve, const PoseSet<4>::PoleTable& P);
+	void calculateUT(const CurveSet& curve, int loop, const CurveIndex& curve_index, const glm::dvec2& P1, const glm::dvec2& P2, const std::pair<int, int>& subscript, std::vector<SpecialPoint>& ret);
 
-	std::vector<std::vector<std::tuple<int, int, int>>> findExtremePoses(const std::vector<glm::dmat4x4>& poses, const std::vector<std::vector<glm::dvec2>>& curve, std::vector<std::vector<glm::dvec2>>& P, std::vector<std::vector<SpecialPoint>>& Q, std::vector<std::vector<SpecialPoint>>& UT);
-	std::pair<int, int> findExtremePoses(const std::vector<std::vector<bool>>& table);
-	std::pair<int, int> findSolution(const std::vector<std::vector<glm::dvec2>>& curves, const glm::dvec2& pt);
-	int findSolution(const std::vector<glm::dvec2>& curve, const glm::dvec2& pt);
+	std::vector<std::vector<std::tuple<int, int, int>>> findExtremePoses(const std::vector<glm::dmat4x4>& poses, const CurveSet& curve, const PoseSet<4>::PoleMatrix& P, std::vector<std::vector<SpecialPoint>>& Q, std::vector<std::vector<SpecialPoint>>& UT);
+	std::vector<std::vector<std::tuple<int, int, int>>> findExtremePoses(const std::array<double, 4>& theta, const CurveSet& curve, const PoseSet<4>::PoleMatrix& P, const std::vector<std::vector<SpecialPoint>>& Q, const std::vector<std::vector<SpecialPoint>>& UT);
+	std::pair<int, int> findExtremePoses(const PoseSet<4>::SignTable& table);
+	std::pair<int, int> findSolution(const CurveSet& curves, const glm::dvec2& pt);
+	int findSolution(const CurveSet& curves, int loop, const glm::dvec2& pt);
+	std::pair<int, int> findSolution(const CurveIndex& curve_index, const glm::dvec2& pt);
 
-	std::vector<std::vector<glm::dvec2>> findValidSolution(const std::vector<glm::dmat4x4>& poses, const std::vector<std::vector<std::vector<glm::dvec2>>>& curves);
+	double lowerBoundOfLength(double a, double b);
+	std::vector<std::vector<glm::dvec2>> findValidSolution(const std::vector<glm::dmat4x4>& poses, const std::vector<CurveSet>& curves, int num_threads = 0);
+	std::vector<SolutionCandidate> findValidSolutions(const std::vector<glm::dmat4x4>& poses, const std::vector<CurveSet>& curves, const SolutionSearchParams& params);
+	std::vector<SolutionCandidate> findValidSolutions(const PoseSet<4>& pose_set, const std::vector<CurveSet>& curves, const SolutionSearchParams& params);
+	std::vector<SolutionCandidate> findValidSolutions(const PoseSet<4>& pose_set, const std::vector<CurveSet>& curves, const SolutionSearchParams& params, bool& completed);
 	int getGrashofType(const glm::dvec2& C1, const glm::dvec2& C2, const glm::dvec2& X1, const glm::dvec2& X2);
 	bool checkGrashofDefect(const glm::dvec2& C1, const glm::dvec2& C2, const glm::dvec2& X1, const glm::dvec2& X2);
 	bool checkOrderDefect(const std::vector<glm::dmat4x4>& poses, const glm::dvec2& C1, const glm::dvec2& C2, const glm::dvec2& X1, const glm::dvec2& X2);
+	bool checkOrderDefect(const CrankContext& crank);
 	bool checkBranchDefect(const std::vector<glm::dmat4x4>& poses, const glm::dvec2& C1, const glm::dvec2& C2, const glm::dvec2& X1, const glm::dvec2& X2);
+	bool checkBranchDefect(const CrankContext& crank1, const CrankContext& crank2, int type);
 
 }
\ No newline at end of file
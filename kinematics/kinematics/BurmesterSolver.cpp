@@ -0,0 +1,136 @@
+#include "BurmesterSolver.h"
+#include <algorithm>
+
+namespace kinematics {
+
+	/**
+	 * Replace all the poses.
+	 */
+	void BurmesterSolver::setPoses(const std::vector<glm::dmat4x4>& poses) {
+		PoseSet<4> old_pose_set = pose_set;
+		pose_set = PoseSet<4>(poses);
+		invalidate(old_pose_set);
+	}
+
+	/**
+	 * Change the i-th pose. Only the poles P_{ij} and theta_i are recalculated here.
+	 */
+	void BurmesterSolver::setPose(int i, const glm::dmat4x4& pose) {
+		if (pose == pose_set.poses[i]) return;
+
+		PoseSet<4> old_pose_set = pose_set;
+		pose_set.setPose(i, pose);
+		invalidate(old_pose_set);
+	}
+
+	void BurmesterSolver::setParams(const CurveSamplingParams& params) {
+		this->params = params;
+		stage = STAGE_POSES;
+	}
+
+	const std::vector<CurveSet>& BurmesterSolver::getSolutions() {
+		update(STAGE_SOLUTIONS);
+		return solutions;
+	}
+
+	const std::vector<CurveIndex>& BurmesterSolver::getSolutionIndices() {
+		update(STAGE_SOLUTIONS);
+		return solution_indices;
+	}
+
+	const std::vector<std::vector<std::vector<SpecialPoint>>>& BurmesterSolver::getPoleIntersections() {
+		update(STAGE_SPECIAL_POINTS);
+		return pole_intersections;
+	}
+
+	const std::vector<std::vector<SpecialPoint>>& BurmesterSolver::getUTs() {
+		update(STAGE_SPECIAL_POINTS);
+		return UTs;
+	}
+
+	const std::vector<std::vector<std::tuple<int, int, int>>>& BurmesterSolver::getExtremePoses() {
+		update(STAGE_EXTREME_POSES);
+		return extreme_poses;
+	}
+
+	const ExtremePoseIndex& BurmesterSolver::getExtremePoseIndex() {
+		update(STAGE_EXTREME_POSES);
+		return extreme_pose_index;
+	}
+
+	/**
+	 * Find the valid solutions on the current solution curves.
+	 * The search always runs again, since its result depends on the search parameters.
+	 * completed is false if the search was interrupted by the time limit or the cancellation.
+	 */
+	std::vector<SolutionCandidate> BurmesterSolver::findValidSolutions(const SolutionSearchParams& params) {
+		bool completed;
+		return findValidSolutions(params, completed);
+	}
+
+	std::vector<SolutionCandidate> BurmesterSolver::findValidSolutions(const SolutionSearchParams& params, bool& completed) {
+		update(STAGE_SOLUTIONS);
+		return kinematics::findValidSolutions(pose_set, solutions, params, completed);
+	}
+
+	/**
+	 * Invalidate the stages whose inputs differ between the old poses and the current poses.
+	 * The solution curves use only P_{12}, P_{13}, P_{14}, P_{23}, P_{24}, theta_1 - theta_2, and theta_1 - theta_3.
+	 * The pole intersections and Us and Ts use all the poles and the image poles, which are derived from the poles.
+	 * The extreme poses use the image poles and only the order of the angles theta_i.
+	 * The values are compared exactly, so a stage is kept only if its result would be exactly the same.
+	 */
+	void BurmesterSolver::invalidate(const PoseSet<4>& old_pose_set) {
+		const PoseSet<4>::PoleMatrix& P_old = old_pose_set.P[0];
+		const PoseSet<4>::PoleMatrix& P_new = pose_set.P[0];
+		const std::array<double, 4>& theta_old = old_pose_set.theta;
+		const std::array<double, 4>& theta_new = pose_set.theta;
+
+		if (P_old[0][1] != P_new[0][1] || P_old[0][2] != P_new[0][2] || P_old[0][3] != P_new[0][3] || P_old[1][2] != P_new[1][2] || P_old[1][3] != P_new[1][3]
+			|| theta_old[0] - theta_old[1] != theta_new[0] - theta_new[1] || theta_old[0] - theta_old[2] != theta_new[0] - theta_new[2]) {
+			stage = STAGE_POSES;
+			return;
+		}
+
+		if (P_old != P_new) {
+			stage = std::min(stage, (int)STAGE_SOLUTIONS);
+			return;
+		}
+
+		for (int j = 0; j < 4; j++) {
+			for (int k = 0; k < 4; k++) {
+				if (j != k && (theta_old[j] > theta_old[k]) != (theta_new[j] > theta_new[k])) {
+					stage = std::min(stage, (int)STAGE_SPECIAL_POINTS);
+					return;
+				}
+			}
+		}
+	}
+
+	/**
+	 * Run the stages of the pipeline that are out of date up to the given stage.
+	 */
+	void BurmesterSolver::update(int stage) {
+		if (this->stage < STAGE_SOLUTIONS && stage >= STAGE_SOLUTIONS) {
+			calculateSolutionCurve(pose_set, solutions, params);
+			solution_indices.resize(solutions.size());
+			for (int i = 0; i < solutions.size(); i++) {
+				solution_indices[i].build(solutions[i]);
+			}
+			this->stage = STAGE_SOLUTIONS;
+		}
+
+		if (this->stage < STAGE_SPECIAL_POINTS && stage >= STAGE_SPECIAL_POINTS) {
+			pole_intersections = calculatePoleIntersections(pose_set.P, solutions, solution_indices);
+			UTs = calculateUTs(solutions[1], pose_set.P);
+			this->stage = STAGE_SPECIAL_POINTS;
+		}
+
+		if (this->stage < STAGE_EXTREME_POSES && stage >= STAGE_EXTREME_POSES) {
+			extreme_poses = findExtremePoses(pose_set.theta, solutions[1], pose_set.P[1], pole_intersections[1], UTs);
+			extreme_pose_index.build(solutions[1], extreme_poses);
+			this->stage = STAGE_EXTREME_POSES;
+		}
+	}
+
+}
\ No newline at end of file
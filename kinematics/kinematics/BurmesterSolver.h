@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <tuple>
+#include <glm/glm.hpp>
+#include "Burmester.h"
+#include "PoseSet.h"
+#include "CurveSet.h"
+#include "CurveIndex.h"
+#include "ExtremePoseIndex.h"
+
+namespace kinematics {
+
+	/**
+	 * Incremental solver of the four-position synthesis for editing the poses interactively.
+	 * It keeps the products of the pipeline, i.e., the poles, the solution curves and their indices, the pole intersections,
+	 * Us and Ts, and the extreme poses, and each of them is calculated on demand only if it is out of date.
+	 * When a pose is changed, only the poles and the angle that involve the pose are recalculated right away,
+	 * and a stage is invalidated only if the poles or the angles it uses have changed (see invalidate).
+	 * Note that a rigid move of the i-th pose moves all the three poles P_{ij}, and the curves use at least two of them
+	 * for every i, so such an edit still recalculates the curves, the special points, and the extreme poses.
+	 * What is kept is the work for the edits that leave the poles unchanged, e.g., setting the same poses again,
+	 * or changing only the entries of a pose matrix that do not move the coupler in the plane.
+	 * The search of the valid solutions is not cached at all, and runs again on every call.
+	 */
+	class BurmesterSolver {
+	public:
+		static enum { STAGE_POSES = 0, STAGE_SOLUTIONS, STAGE_SPECIAL_POINTS, STAGE_EXTREME_POSES };
+
+	private:
+		PoseSet<4> pose_set;
+		CurveSamplingParams params;
+		int stage;
+		std::vector<CurveSet> solutions;
+		std::vector<CurveIndex> solution_indices;
+		std::vector<std::vector<std::vector<SpecialPoint>>> pole_intersections;
+		std::vector<std::vector<SpecialPoint>> UTs;
+		std::vector<std::vector<std::tuple<int, int, int>>> extreme_poses;
+		ExtremePoseIndex extreme_pose_index;
+
+	public:
+		BurmesterSolver(const std::vector<glm::dmat4x4>& poses, const CurveSamplingParams& params = CurveSamplingParams()) : pose_set(poses), params(params), stage(STAGE_POSES) {}
+
+		void setPoses(const std::vector<glm::dmat4x4>& poses);
+		void setPose(int i, const glm::dmat4x4& pose);
+		void setParams(const CurveSamplingParams& params);
+
+		const PoseSet<4>& getPoseSet() const { return pose_set; }
+		const std::vector<CurveSet>& getSolutions();
+		const std::vector<CurveIndex>& getSolutionIndices();
+		const std::vector<std::vector<std::vector<SpecialPoint>>>& getPoleIntersections();
+		const std::vector<std::vector<SpecialPoint>>& getUTs();
+		const std::vector<std::vector<std::tuple<int, int, int>>>& getExtremePoses();
+		const ExtremePoseIndex& getExtremePoseIndex();
+		std::vector<SolutionCandidate> findValidSolutions(const SolutionSearchParams& params);
+		std::vector<SolutionCandidate> findValidSolutions(const SolutionSearchParams& params, bool& completed);
+
+	private:
+		void invalidate(const PoseSet<4>& old_pose_set);
+		void update(int stage);
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,387 @@
+#include "CompactDiagram.h"
+#include "KinematicDiagram.h"
+#include "SolveSchedule.h"
+#include "Gear.h"
+#include "KinematicUtils.h"
+#include <map>
+
+namespace kinematics {
+
+	/**
+	 * Rebuild the arrays if the diagram has been changed since they were built.
+	 */
+	void CompactDiagram::update(KinematicDiagram& diagram) {
+		if (revision != diagram.revision) {
+			build(diagram);
+		}
+	}
+
+	/**
+	 * Build the arrays from the joints, the links, and the bodies of the diagram,
+	 * compile the forward kinematics into the steps, and recognize the closed-form linkage.
+	 * The revision is set only when the build succeeds, so that a failed build is retried by update().
+	 */
+	void CompactDiagram::build(KinematicDiagram& diagram) {
+		clear();
+
+		std::map<const Joint*, int> joint_indices;
+		std::map<const Link*, int> link_indices;
+
+		for (auto it = diagram.joints.begin(); it != diagram.joints.end(); ++it) {
+			Joint* joint = it->second.get();
+			joint_indices[joint] = joint_objects.size();
+			joint_objects.push_back(joint);
+
+			joint_ids.push_back(joint->id);
+			joint_types.push_back(joint->type);
+			grounds.push_back(joint->ground ? 1 : 0);
+			positions.push_back(joint->pos);
+			determined.push_back(joint->determined ? 1 : 0);
+
+			if (joint->type == Joint::TYPE_GEAR) {
+				const Gear* gear = static_cast<const Gear*>(joint);
+				gear_indices.push_back(gear_centers.size());
+				gear_centers.push_back(gear->center);
+				gear_radii.push_back(gear->radius);
+				gear_speeds.push_back(gear->speed);
+				gear_phases.push_back(gear->phase);
+			}
+			else {
+				gear_indices.push_back(-1);
+			}
+		}
+
+		for (auto it = diagram.links.begin(); it != diagram.links.end(); ++it) {
+			Link* link = it->second.get();
+			link_indices[link] = link_objects.size();
+			link_objects.push_back(link);
+
+			if (!link->hasTables()) link->updateTables();
+			link_offsets.push_back(link_joints.size());
+			for (int i = 0; i < link->joints.size(); ++i) {
+				link_joints.push_back(joint_indices[link->joints[i].get()]);
+				link_shapes.push_back(link->shape[i]);
+			}
+			drivers.push_back(link->driver ? 1 : 0);
+			angles.push_back(link->angle);
+		}
+		link_offsets.push_back(link_joints.size());
+
+		for (int i = 0; i < joint_objects.size(); ++i) {
+			joint_link_offsets.push_back(joint_links.size());
+			for (int j = 0; j < joint_objects[i]->links.size(); ++j) {
+				joint_links.push_back(link_indices[joint_objects[i]->links[j].get()]);
+			}
+		}
+		joint_link_offsets.push_back(joint_links.size());
+
+		for (int i = 0; i < diagram.bodies.size(); ++i) {
+			body_pivots.push_back(joint_indices[diagram.bodies[i]->pivot1.get()]);
+			body_pivots.push_back(joint_indices[diagram.bodies[i]->pivot2.get()]);
+			body_offsets.push_back(body_points.size());
+			body_points.insert(body_points.end(), diagram.bodies[i]->points.begin(), diagram.bodies[i]->points.end());
+		}
+		body_offsets.push_back(body_points.size());
+
+		body_neighbors.resize(diagram.bodies.size() * diagram.bodies.size(), 0);
+		for (int i = 0; i < diagram.bodies.size(); ++i) {
+			for (auto it = diagram.bodies[i]->neighbors.begin(); it != diagram.bodies[i]->neighbors.end(); ++it) {
+				if (it->second) body_neighbors[i * diagram.bodies.size() + it->first] = 1;
+			}
+		}
+		actual_points.resize(diagram.bodies.size());
+
+		compile(diagram);
+		linkage.recognize(diagram);
+		revision = diagram.revision;
+	}
+
+	/**
+	 * Compile the forward kinematics for the determined flags that the drivers set at the beginning of each step,
+	 * i.e., the ground joints and the joints of the driver links rotated by the ground pin joints.
+	 * The schedule is compiled on the joint objects, whose determined flags are restored afterward.
+	 */
+	void CompactDiagram::compile(KinematicDiagram& diagram) {
+		for (int i = 0; i < joint_objects.size(); ++i) {
+			joint_objects[i]->determined = grounds[i] != 0;
+		}
+		for (int i = 0; i < joint_objects.size(); ++i) {
+			if (!grounds[i] || joint_types[i] != Joint::TYPE_PIN) continue;
+
+			for (int j = joint_link_offsets[i]; j < joint_link_offsets[i + 1]; ++j) {
+				if (!drivers[joint_links[j]]) continue;
+
+				for (int k = link_offsets[joint_links[j]]; k < link_offsets[joint_links[j] + 1]; ++k) {
+					joint_objects[link_joints[k]]->determined = true;
+				}
+			}
+		}
+
+		SolveSchedule schedule;
+		try {
+			schedule.compile(diagram);
+		}
+		catch (char* ex) {
+			for (int i = 0; i < joint_objects.size(); ++i) {
+				joint_objects[i]->determined = determined[i] != 0;
+			}
+			throw ex;
+		}
+		for (int i = 0; i < joint_objects.size(); ++i) {
+			joint_objects[i]->determined = determined[i] != 0;
+		}
+
+		std::map<const Joint*, int> joint_indices;
+		std::map<const Link*, int> link_indices;
+		for (int i = 0; i < joint_objects.size(); ++i) {
+			joint_indices[joint_objects[i]] = i;
+		}
+		for (int i = 0; i < link_objects.size(); ++i) {
+			link_indices[link_objects[i]] = i;
+		}
+
+		for (int i = 0; i < schedule.steps.size(); ++i) {
+			const SolveStep& step = schedule.steps[i];
+
+			CompactStep compact_step;
+			compact_step.type = step.type;
+			compact_step.joint = joint_indices[step.joint];
+			if (step.type == SolveStep::TYPE_JOINT && gear_indices[compact_step.joint] < 0) throw "Unsupported joint.";
+			if (step.type == SolveStep::TYPE_RIGID) {
+				int link = link_indices[step.link];
+				compact_step.slot1 = link_offsets[link] + step.index1;
+				compact_step.slot2 = link_offsets[link] + step.index2;
+				compact_step.slot = link_offsets[link] + step.index;
+			}
+
+			int num_joints = 0;
+			int num_lengths = 0;
+			if (step.type == SolveStep::TYPE_DYAD || step.type == SolveStep::TYPE_SLIDER_DYAD) {
+				num_joints = 2;
+				num_lengths = 2;
+			}
+			else if (step.type == SolveStep::TYPE_TRIAD) {
+				num_joints = 5;
+				num_lengths = 6;
+			}
+			for (int j = 0; j < num_joints; ++j) {
+				compact_step.joints[j] = joint_indices[step.joints[j]];
+			}
+			for (int j = 0; j < num_lengths; ++j) {
+				compact_step.lengths[j] = step.lengths[j].get();
+			}
+
+			steps.push_back(compact_step);
+		}
+	}
+
+	/**
+	 * Write the positions, the determined flags, the phases of the gears, and the angles of the links
+	 * back to the joints and the links of the diagram that the arrays were built from.
+	 */
+	void CompactDiagram::store() const {
+		for (int i = 0; i < joint_objects.size(); ++i) {
+			joint_objects[i]->pos = positions[i];
+			joint_objects[i]->determined = determined[i] != 0;
+			if (gear_indices[i] >= 0) {
+				static_cast<Gear*>(joint_objects[i])->phase = gear_phases[gear_indices[i]];
+			}
+		}
+		for (int i = 0; i < link_objects.size(); ++i) {
+			link_objects[i]->angle = angles[i];
+		}
+	}
+
+	void CompactDiagram::clear() {
+		revision = 0;
+		joint_ids.clear();
+		joint_types.clear();
+		grounds.clear();
+		positions.clear();
+		determined.clear();
+		gear_indices.clear();
+		gear_centers.clear();
+		gear_radii.clear();
+		gear_speeds.clear();
+		gear_phases.clear();
+		link_offsets.clear();
+		link_joints.clear();
+		link_shapes.clear();
+		drivers.clear();
+		angles.clear();
+		joint_link_offsets.clear();
+		joint_links.clear();
+		body_pivots.clear();
+		body_offsets.clear();
+		body_points.clear();
+		body_neighbors.clear();
+		steps.clear();
+		linkage = DyadLinkage();
+		joint_objects.clear();
+		link_objects.clear();
+		actual_points.clear();
+	}
+
+	/**
+	 * Return the number of values in the state of the simulation, i.e.,
+	 * the positions and the determined flags of the joints, the phases of the gears, and the angles of the links.
+	 */
+	int CompactDiagram::stateSize() const {
+		return positions.size() * 3 + gear_phases.size() + angles.size();
+	}
+
+	void CompactDiagram::saveState(std::vector<double>& state) const {
+		state.resize(stateSize());
+
+		int index = 0;
+		for (int i = 0; i < positions.size(); ++i) {
+			state[index++] = positions[i].x;
+			state[index++] = positions[i].y;
+		}
+		for (int i = 0; i < determined.size(); ++i) {
+			state[index++] = determined[i];
+		}
+		for (int i = 0; i < gear_phases.size(); ++i) {
+			state[index++] = gear_phases[i];
+		}
+		for (int i = 0; i < angles.size(); ++i) {
+			state[index++] = angles[i];
+		}
+	}
+
+	void CompactDiagram::restoreState(const std::vector<double>& state) {
+		if (state.size() != stateSize()) throw "Invalid state.";
+
+		int index = 0;
+		for (int i = 0; i < positions.size(); ++i) {
+			positions[i].x = state[index++];
+			positions[i].y = state[index++];
+		}
+		for (int i = 0; i < determined.size(); ++i) {
+			determined[i] = state[index++] != 0;
+		}
+		for (int i = 0; i < gear_phases.size(); ++i) {
+			gear_phases[i] = state[index++];
+		}
+		for (int i = 0; i < angles.size(); ++i) {
+			angles[i] = state[index++];
+		}
+	}
+
+	/**
+	 * Clear the determined flags, and move the joints by the drivers in the same way as Joint::stepForward().
+	 * Return true if there is a ground joint that drives the mechanism.
+	 */
+	bool CompactDiagram::stepDrivers(double step_size) {
+		for (int i = 0; i < determined.size(); ++i) {
+			determined[i] = grounds[i];
+		}
+
+		bool driver_exist = false;
+		for (int i = 0; i < joint_ids.size(); ++i) {
+			if (!grounds[i]) continue;
+			driver_exist = true;
+
+			if (joint_types[i] == Joint::TYPE_PIN) {
+				for (int j = joint_link_offsets[i]; j < joint_link_offsets[i + 1]; ++j) {
+					int link = joint_links[j];
+					if (!drivers[link]) continue;
+
+					for (int k = link_offsets[link]; k < link_offsets[link + 1]; ++k) {
+						rotate(link_joints[k], positions[i], step_size);
+					}
+					angles[link] += step_size;
+				}
+				determined[i] = 1;
+			}
+			else if (joint_types[i] == Joint::TYPE_GEAR) {
+				int gear = gear_indices[i];
+				gear_phases[gear] += gear_speeds[gear] * step_size;
+				positions[i] = gear_centers[gear] + glm::dvec2(cos(gear_phases[gear]), sin(gear_phases[gear])) * gear_radii[gear];
+				determined[i] = 1;
+			}
+		}
+
+		return driver_exist;
+	}
+
+	/**
+	 * Update the positions of the joints by replaying the compiled steps.
+	 */
+	void CompactDiagram::forwardKinematics() {
+		for (int i = 0; i < steps.size(); ++i) {
+			const CompactStep& step = steps[i];
+			glm::dvec2& pos = positions[step.joint];
+
+			if (step.type == SolveStep::TYPE_JOINT) {
+				int gear = gear_indices[step.joint];
+				pos = gear_centers[gear] + glm::dvec2(cos(gear_phases[gear]), sin(gear_phases[gear])) * gear_radii[gear];
+			}
+			else if (step.type == SolveStep::TYPE_RIGID) {
+				glm::dmat3x2 mat = rigidTransform(link_shapes[step.slot1], link_shapes[step.slot2], positions[link_joints[step.slot1]], positions[link_joints[step.slot2]]);
+				pos = mat * glm::dvec3(link_shapes[step.slot], 1);
+			}
+			else if (step.type == SolveStep::TYPE_DYAD) {
+				glm::dvec2 int1, int2;
+				if (!circleCircleIntersection(positions[step.joints[0]], step.lengths[0], positions[step.joints[1]], step.lengths[1], int1, int2)) throw "No intersection";
+
+				// choose the intersection that is closer to the previous position
+				if (glm::length(int1 - pos) <= glm::length(int2 - pos)) {
+					pos = int1;
+				}
+				else {
+					pos = int2;
+				}
+			}
+			else if (step.type == SolveStep::TYPE_SLIDER_DYAD) {
+				pos = circleLineIntersection(positions[step.joints[1]], step.lengths[1], positions[step.joints[0]], pos, pos);
+			}
+			else if (step.type == SolveStep::TYPE_TRIAD) {
+				glm::dvec2 new_pos;
+				if (!kinematics::threeLengths(positions[step.joints[0]], step.lengths[0], positions[step.joints[1]], step.lengths[1], positions[step.joints[2]], step.lengths[2], step.lengths[3], step.lengths[4], step.lengths[5], pos, positions[step.joints[3]], positions[step.joints[4]], new_pos)) throw "No solution";
+
+				pos = new_pos;
+			}
+
+			determined[step.joint] = 1;
+		}
+	}
+
+	/**
+	 * Return true if two bodies that are not adjacent in the original shape intersect.
+	 * The actual points of the bodies are stored in the buffers that are reused across the steps.
+	 */
+	bool CompactDiagram::isCollided() {
+		int num_bodies = numBodies();
+		for (int i = 0; i < num_bodies; ++i) {
+			BodyGeometry::getActualPoints(positions[body_pivots[i * 2]], positions[body_pivots[i * 2 + 1]], body_points.data() + body_offsets[i], body_offsets[i + 1] - body_offsets[i], actual_points[i]);
+		}
+
+		for (int i = 0; i < num_bodies; ++i) {
+			for (int j = i + 1; j < num_bodies; ++j) {
+				// skip the neighbors
+				if (body_neighbors[i * num_bodies + j]) continue;
+
+				if (polygonPolygonIntersection(actual_points[i], actual_points[j])) {
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * Rotate the joint around the center in the same way as Joint::rotate().
+	 * Note that the center may be the position of the joint that is being rotated.
+	 */
+	void CompactDiagram::rotate(int joint, const glm::dvec2& rotation_center, double angle) {
+		double x = positions[joint].x;
+		double y = positions[joint].y;
+		positions[joint].x = cos(angle) * (x - rotation_center.x) - sin(angle) * (y - rotation_center.y) + rotation_center.x;
+		positions[joint].y = sin(angle) * (x - rotation_center.x) + cos(angle) * (y - rotation_center.y) + rotation_center.y;
+
+		determined[joint] = 1;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "DyadLinkage.h"
+
+namespace kinematics {
+
+	class Joint;
+	class Link;
+	class KinematicDiagram;
+
+	/**
+	 * One operation of the compiled forward kinematics on the arrays of CompactDiagram.
+	 * The type and the operands are the same as SolveStep, except that the joints are the indices of the joints,
+	 * the positions in the link are the indices into link_joints and link_shapes (slots),
+	 * and the lengths are copied from the length tables of the links when the step is compiled.
+	 *  slot1, slot2: the two determined joints of the link for TYPE_RIGID.
+	 *  slot:         this joint in the link for TYPE_RIGID.
+	 */
+	class CompactStep {
+	public:
+		int type;
+		int joint;
+		int slot1;
+		int slot2;
+		int slot;
+		int joints[5];
+		double lengths[6];
+
+	public:
+		CompactStep() : type(0), joint(-1), slot1(-1), slot2(-1), slot(-1) {}
+	};
+
+	/**
+	 * The compact representation of the kinematic diagram for the simulation.
+	 * The joints are stored in the order of their ids in contiguous arrays, the joints of each link are
+	 * stored as a span of link_joints, and the links of each joint are stored in the CSR format.
+	 * The arrays are built from the diagram when its revision changes, the simulation runs on the arrays,
+	 * and the result is written back to the joints and the links by store().
+	 * If the diagram is a four-bar linkage or a slider-crank, it is also recognized as linkage for the closed-form solver.
+	 */
+	class CompactDiagram {
+	public:
+		int revision;
+
+		// joints
+		std::vector<int> joint_ids;
+		std::vector<int> joint_types;
+		std::vector<char> grounds;
+		std::vector<glm::dvec2> positions;
+		std::vector<char> determined;
+		std::vector<int> gear_indices;
+
+		// gears
+		std::vector<glm::dvec2> gear_centers;
+		std::vector<double> gear_radii;
+		std::vector<double> gear_speeds;
+		std::vector<double> gear_phases;
+
+		// the joints of the i-th link are link_joints[link_offsets[i]], ..., link_joints[link_offsets[i + 1] - 1],
+		// and link_shapes stores their positions in the original shape of the link
+		std::vector<int> link_offsets;
+		std::vector<int> link_joints;
+		std::vector<glm::dvec2> link_shapes;
+		std::vector<char> drivers;
+		std::vector<double> angles;
+
+		// the links of the j-th joint are joint_links[joint_link_offsets[j]], ..., joint_links[joint_link_offsets[j + 1] - 1]
+		std::vector<int> joint_link_offsets;
+		std::vector<int> joint_links;
+
+		// the points of the i-th body are body_points[body_offsets[i]], ..., body_points[body_offsets[i + 1] - 1]
+		std::vector<int> body_pivots;
+		std::vector<int> body_offsets;
+		std::vector<glm::dvec2> body_points;
+		std::vector<char> body_neighbors;
+
+		std::vector<CompactStep> steps;
+		DyadLinkage linkage;
+
+	private:
+		std::vector<Joint*> joint_objects;
+		std::vector<Link*> link_objects;
+		std::vector<std::vector<glm::dvec2>> actual_points;
+
+	public:
+		CompactDiagram() : revision(0) {}
+
+		int numJoints() const { return joint_ids.size(); }
+		int numLinks() const { return drivers.size(); }
+		int numBodies() const { return body_pivots.size() / 2; }
+		void update(KinematicDiagram& diagram);
+		void build(KinematicDiagram& diagram);
+		void store() const;
+		void clear();
+		int stateSize() const;
+		void saveState(std::vector<double>& state) const;
+		void restoreState(const std::vector<double>& state);
+		bool stepDrivers(double step_size);
+		void forwardKinematics();
+		bool isCollided();
+
+	private:
+		void compile(KinematicDiagram& diagram);
+		void rotate(int joint, const glm::dvec2& rotation_center, double angle);
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,237 @@
+#include "CurveFile.h"
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace kinematics {
+
+	static uint64_t align8(uint64_t pos) {
+		return (pos + 7) & ~(uint64_t)7;
+	}
+
+	/**
+	 * Write the curve sets to the binary curve file.
+	 * All the curve sets must have loops of the same sizes, and labels must be empty or have a label for each point.
+	 */
+	bool writeCurveFile(const std::string& filename, const std::vector<CurveSet>& curves, const std::vector<bool>& labels) {
+		if (curves.size() == 0) return false;
+		for (int i = 1; i < curves.size(); i++) {
+			if (curves[i].offsets != curves[0].offsets) return false;
+		}
+		if (labels.size() > 0 && labels.size() != curves[0].numPoints()) return false;
+
+		uint64_t num_points = curves[0].numPoints();
+		int num_loops = curves[0].numLoops();
+
+		CurveFileHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, "BCRV", 4);
+		header.version = CurveFileHeader::VERSION;
+		header.num_curves = curves.size();
+		header.num_loops = num_loops;
+		header.num_points = num_points;
+		header.offsets_pos = align8(sizeof(CurveFileHeader));
+		header.closed_pos = align8(header.offsets_pos + sizeof(int32_t) * (num_loops + 1));
+		header.coords_pos = align8(header.closed_pos + num_loops * curves.size());
+		uint64_t end = header.coords_pos + sizeof(double) * num_points * 2 * curves.size();
+		if (labels.size() > 0) {
+			header.labels_pos = align8(end);
+			end = header.labels_pos + sizeof(uint64_t) * ((num_points + 63) / 64);
+		}
+		header.file_size = end;
+
+		std::vector<char> buffer(header.file_size, 0);
+		memcpy(&buffer[0], &header, sizeof(header));
+
+		int32_t* offsets = (int32_t*)&buffer[header.offsets_pos];
+		for (int i = 0; i <= num_loops; i++) {
+			offsets[i] = curves[0].offsets[i];
+		}
+		for (int i = 0; i < curves.size(); i++) {
+			for (int j = 0; j < num_loops; j++) {
+				buffer[header.closed_pos + num_loops * i + j] = curves[i].closed[j] ? 1 : 0;
+			}
+		}
+		for (int i = 0; i < curves.size(); i++) {
+			if (num_points == 0) break;
+			memcpy(&buffer[header.coords_pos + sizeof(double) * num_points * i * 2], curves[i].x.data(), sizeof(double) * num_points);
+			memcpy(&buffer[header.coords_pos + sizeof(double) * num_points * (i * 2 + 1)], curves[i].y.data(), sizeof(double) * num_points);
+		}
+		if (labels.size() > 0) {
+			uint64_t* bits = (uint64_t*)&buffer[header.labels_pos];
+			for (uint64_t i = 0; i < num_points; i++) {
+				if (labels[i]) bits[i >> 6] |= (uint64_t)1 << (i & 63);
+			}
+		}
+
+		std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+		if (!out) return false;
+		out.write(&buffer[0], buffer.size());
+		return (bool)out;
+	}
+
+	/**
+	 * Read the solution curve in the CSV format, in which each line has the center point, the circle point,
+	 * and the label (OK or NG), i.e., "Cx,Cy,Xx,Xy,OK". The points are stored as one loop of the center point curve
+	 * (curves[0]) and the circle point curve (curves[1]), and the label is true for OK.
+	 */
+	bool readCurveCsv(const std::string& filename, std::vector<CurveSet>& curves, std::vector<bool>& labels) {
+		std::ifstream in(filename);
+		if (!in) return false;
+
+		curves.clear();
+		curves.resize(2);
+		curves[0].addLoop();
+		curves[1].addLoop();
+		labels.clear();
+
+		std::string line;
+		while (std::getline(in, line)) {
+			if (line.empty() || line == "\r") continue;
+
+			std::istringstream ss(line);
+			std::vector<std::string> fields;
+			std::string field;
+			while (std::getline(ss, field, ',')) fields.push_back(field);
+			if (fields.size() < 4) return false;
+
+			try {
+				curves[0].addPoint(glm::dvec2(std::stod(fields[0]), std::stod(fields[1])));
+				curves[1].addPoint(glm::dvec2(std::stod(fields[2]), std::stod(fields[3])));
+			}
+			catch (...) {
+				return false;
+			}
+			labels.push_back(fields.size() >= 5 && fields[4].compare(0, 2, "OK") == 0);
+		}
+
+		return true;
+	}
+
+	/**
+	 * Map the binary curve file into memory. If the file cannot be mapped or is broken, false is returned.
+	 */
+	bool CurveFileView::open(const std::string& filename) {
+		close();
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE) return false;
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+			CloseHandle(file);
+			return false;
+		}
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL) {
+			CloseHandle(file);
+			return false;
+		}
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (view == NULL) {
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+		file_handle = file;
+		mapping_handle = mapping;
+		data = (const char*)view;
+		data_size = file_size.QuadPart;
+#else
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if (fd < 0) return false;
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size == 0) {
+			::close(fd);
+			return false;
+		}
+		void* view = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (view == MAP_FAILED) return false;
+		data = (const char*)view;
+		data_size = st.st_size;
+#endif
+
+		header = (const CurveFileHeader*)data;
+		if (!validate()) {
+			close();
+			return false;
+		}
+
+		offsets = (const int32_t*)(data + header->offsets_pos);
+		closed = (const uint8_t*)(data + header->closed_pos);
+		coords = (const double*)(data + header->coords_pos);
+		labels = header->labels_pos > 0 ? (const uint64_t*)(data + header->labels_pos) : NULL;
+		return true;
+	}
+
+	void CurveFileView::close() {
+		if (data != NULL) {
+#ifdef _WIN32
+			UnmapViewOfFile(data);
+			CloseHandle((HANDLE)mapping_handle);
+			CloseHandle((HANDLE)file_handle);
+#else
+			munmap((void*)data, data_size);
+#endif
+		}
+
+		header = NULL;
+		offsets = NULL;
+		closed = NULL;
+		coords = NULL;
+		labels = NULL;
+		data = NULL;
+		data_size = 0;
+		file_handle = NULL;
+		mapping_handle = NULL;
+	}
+
+	/**
+	 * Copy the curve-th curve set into a CurveSet.
+	 */
+	void CurveFileView::toCurveSet(int curve, CurveSet& curves) const {
+		curves.x.assign(x(curve), x(curve) + numPoints());
+		curves.y.assign(y(curve), y(curve) + numPoints());
+		curves.offsets.assign(offsets, offsets + numLoops() + 1);
+		curves.closed.assign(closed + numLoops() * curve, closed + numLoops() * (curve + 1));
+	}
+
+	/**
+	 * Check that the header is of this format and version, and all the sections and loops are within the file.
+	 */
+	bool CurveFileView::validate() const {
+		if (data_size < sizeof(CurveFileHeader)) return false;
+		if (memcmp(header->magic, "BCRV", 4) != 0 || header->version != CurveFileHeader::VERSION) return false;
+		if (header->file_size != data_size) return false;
+
+		uint64_t num_points = header->num_points;
+		uint64_t num_loops = header->num_loops;
+		if (num_points > 0x7fffffff || num_loops > 0x7fffffff || header->num_curves == 0 || header->num_curves > 0xffff) return false;
+		if (header->offsets_pos % 8 != 0 || header->coords_pos % 8 != 0 || header->labels_pos % 8 != 0) return false;
+		if (header->offsets_pos < sizeof(CurveFileHeader) || header->offsets_pos + sizeof(int32_t) * (num_loops + 1) > data_size) return false;
+		if (header->closed_pos > data_size || header->closed_pos + num_loops * header->num_curves > data_size) return false;
+		if (header->coords_pos > data_size || header->coords_pos + sizeof(double) * num_points * 2 * header->num_curves > data_size) return false;
+		if (header->labels_pos > 0 && (header->labels_pos > data_size || header->labels_pos + sizeof(uint64_t) * ((num_points + 63) / 64) > data_size)) return false;
+
+		const int32_t* offsets = (const int32_t*)(data + header->offsets_pos);
+		if (offsets[0] != 0 || offsets[num_loops] != num_points) return false;
+		for (uint64_t i = 0; i < num_loops; i++) {
+			if (offsets[i] > offsets[i + 1]) return false;
+		}
+
+		return true;
+	}
+
+}
\ No newline at end of file
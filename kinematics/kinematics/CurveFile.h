@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "CurveSet.h"
+
+namespace kinematics {
+
+	/**
+	 * Header of the binary curve file, which stores num_curves curve sets that share the same loops
+	 * (e.g., the center point curve and the circle point curve) and a label bit for each point.
+	 * The sections follow the header at the given byte positions, each aligned to 8 bytes:
+	 * - loop offsets: int32[num_loops + 1]
+	 * - closed flags: uint8[num_loops]
+	 * - coordinates: double[num_curves][2][num_points], i.e., x and y of each curve set
+	 * - labels: uint64[(num_points + 63) / 64], bit i of which is the label of the i-th point (absent if labels_pos is 0)
+	 * All the values are stored in the byte order of the writer, which is little-endian on the supported platforms.
+	 */
+	class CurveFileHeader {
+	public:
+		static const uint32_t VERSION = 1;
+
+		char magic[4];
+		uint32_t version;
+		uint32_t num_curves;
+		uint32_t num_loops;
+		uint64_t num_points;
+		uint64_t offsets_pos;
+		uint64_t closed_pos;
+		uint64_t coords_pos;
+		uint64_t labels_pos;
+		uint64_t file_size;
+	};
+
+	bool writeCurveFile(const std::string& filename, const std::vector<CurveSet>& curves, const std::vector<bool>& labels = std::vector<bool>());
+	bool readCurveCsv(const std::string& filename, std::vector<CurveSet>& curves, std::vector<bool>& labels);
+
+	/**
+	 * Read-only view of a binary curve file mapped into memory.
+	 * The arrays point directly into the mapped file, so opening a file does not copy or parse the points.
+	 * The view is valid until it is closed or destroyed.
+	 */
+	class CurveFileView {
+	public:
+		const CurveFileHeader* header;
+		const int32_t* offsets;
+		const uint8_t* closed;
+		const double* coords;
+		const uint64_t* labels;
+
+	private:
+		const char* data;
+		uint64_t data_size;
+		void* file_handle;
+		void* mapping_handle;
+
+	public:
+		CurveFileView() : header(NULL), offsets(NULL), closed(NULL), coords(NULL), labels(NULL), data(NULL), data_size(0), file_handle(NULL), mapping_handle(NULL) {}
+		~CurveFileView() { close(); }
+
+		bool open(const std::string& filename);
+		void close();
+		bool isOpen() const { return data != NULL; }
+
+		int numCurves() const { return header->num_curves; }
+		int numLoops() const { return header->num_loops; }
+		int numPoints() const { return (int)header->num_points; }
+		int size(int loop) const { return offsets[loop + 1] - offsets[loop]; }
+		bool isClosed(int curve, int loop) const { return closed[header->num_loops * curve + loop] != 0; }
+		const double* x(int curve) const { return coords + header->num_points * curve * 2; }
+		const double* y(int curve) const { return coords + header->num_points * (curve * 2 + 1); }
+		glm::dvec2 point(int curve, int index) const { return glm::dvec2(x(curve)[index], y(curve)[index]); }
+		glm::dvec2 point(int curve, int loop, int index) const { return point(curve, offsets[loop] + index); }
+		bool hasLabels() const { return labels != NULL; }
+		bool label(int index) const { return (labels[index >> 6] >> (index & 63)) & 1; }
+
+		void toCurveSet(int curve, CurveSet& curves) const;
+
+	private:
+		CurveFileView(const CurveFileView&);
+		CurveFileView& operator=(const CurveFileView&);
+		bool validate() const;
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "CurveIndex.h"
+#include <algorithm>
+#include <limits>
+
+namespace kinematics {
+
+	CurveIndex::CurveIndex(const CurveSet& curves) {
+		build(curves);
+	}
+
+	CurveIndex::CurveIndex(const CurveSet& curves, int loop) {
+		build(curves, loop);
+	}
+
+	void CurveIndex::build(const CurveSet& curves) {
+		build(curves, 0, curves.numLoops());
+	}
+
+	/**
+	 * Build the index only for the points of the given loop.
+	 * The nearest point is still returned as (loop index, index in the loop).
+	 */
+	void CurveIndex::build(const CurveSet& curves, int loop) {
+		build(curves, loop, loop + 1);
+	}
+
+	void CurveIndex::build(const CurveSet& curves, int first_loop, int last_loop) {
+		points.clear();
+		indices.clear();
+		flat_indices.clear();
+
+		// sort the points into the kd-tree order
+		std::vector<int> order;
+		order.reserve(curves.offsets[last_loop] - curves.offsets[first_loop]);
+		for (int i = curves.offsets[first_loop]; i < curves.offsets[last_loop]; i++) order.push_back(i);
+		build(curves, order, 0, order.size(), 0);
+
+		points.resize(order.size());
+		indices.resize(order.size());
+		flat_indices = order;
+		for (int i = 0; i < order.size(); i++) {
+			points[i] = curves.point(order[i]);
+
+			// find the loop of the point by binary search on the loop offsets
+			int loop = std::upper_bound(curves.offsets.begin() + first_loop, curves.offsets.begin() + last_loop + 1, order[i]) - curves.offsets.begin() - 1;
+			indices[i] = { loop, order[i] - curves.offsets[loop] };
+		}
+	}
+
+	/**
+	 * Return the index of the nearest point as (curve index, point index),
+	 * or (-1, -1) if there is no point or the distance cannot be compared (e.g., pt is not finite).
+	 * If multiple points have the same distance, the one that comes first in the curves is returned,
+	 * which is the same as the linear scan.
+	 */
+	std::pair<int, int> CurveIndex::findNearest(const glm::dvec2& pt) const {
+		if (empty()) return { -1, -1 };
+
+		int best = -1;
+		double min_dist = std::numeric_limits<double>::max();
+		findNearest(0, points.size(), 0, pt, best, min_dist);
+		if (best < 0) return { -1, -1 };
+
+		return indices[best];
+	}
+
+	void CurveIndex::build(const CurveSet& curves, std::vector<int>& order, int lo, int hi, int axis) {
+		if (hi - lo <= 1) return;
+
+		// the median along the axis becomes the node
+		int mid = (lo + hi) / 2;
+		std::nth_element(order.begin() + lo, order.begin() + mid, order.begin() + hi, [&curves, axis](int i1, int i2) { return curves.point(i1)[axis] < curves.point(i2)[axis]; });
+
+		build(curves, order, lo, mid, 1 - axis);
+		build(curves, order, mid + 1, hi, 1 - axis);
+	}
+
+	void CurveIndex::findNearest(int lo, int hi, int axis, const glm::dvec2& pt, int& best, double& min_dist) const {
+		if (hi <= lo) return;
+
+		int mid = (lo + hi) / 2;
+		double dist = glm::length(points[mid] - pt);
+		if (dist < min_dist || (dist == min_dist && (best < 0 || flat_indices[mid] < flat_indices[best]))) {
+			min_dist = dist;
+			best = mid;
+		}
+
+		// visit the side that contains the point first, and the other side only if it may contain a closer point
+		double diff = pt[axis] - points[mid][axis];
+		if (diff < 0) {
+			findNearest(lo, mid, 1 - axis, pt, best, min_dist);
+			if (-diff <= min_dist) findNearest(mid + 1, hi, 1 - axis, pt, best, min_dist);
+		}
+		else {
+			findNearest(mid + 1, hi, 1 - axis, pt, best, min_dist);
+			if (diff <= min_dist) findNearest(lo, mid, 1 - axis, pt, best, min_dist);
+		}
+	}
+
+}
\ No newline at end of file
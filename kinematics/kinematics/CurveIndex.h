@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "CurveSet.h"
+
+namespace kinematics {
+
+	/**
+	 * Static kd-tree over the points of a set of curves (or one loop of it) for the nearest point queries.
+	 * The tree is stored implicitly in an array, i.e., the median of the range [lo, hi) is the node, and
+	 * [lo, mid) and [mid + 1, hi) are its children. The split axis alternates between x and y.
+	 */
+	class CurveIndex {
+	public:
+		std::vector<glm::dvec2> points;
+		std::vector<std::pair<int, int>> indices;
+		std::vector<int> flat_indices;
+
+	public:
+		CurveIndex() {}
+		CurveIndex(const CurveSet& curves);
+		CurveIndex(const CurveSet& curves, int loop);
+
+		void build(const CurveSet& curves);
+		void build(const CurveSet& curves, int loop);
+		bool empty() const { return points.size() == 0; }
+		std::pair<int, int> findNearest(const glm::dvec2& pt) const;
+
+	private:
+		void build(const CurveSet& curves, int first_loop, int last_loop);
+		void build(const CurveSet& curves, std::vector<int>& order, int lo, int hi, int axis);
+		void findNearest(int lo, int hi, int axis, const glm::dvec2& pt, int& best, double& min_dist) const;
+	};
+
+}
\ No newline at end of file
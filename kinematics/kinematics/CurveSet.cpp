@@ -0,0 +1,46 @@
+#include "CurveSet.h"
+#include <algorithm>
+
+namespace kinematics {
+
+	void CurveSet::clear() {
+		x.clear();
+		y.clear();
+		offsets.clear();
+		offsets.push_back(0);
+		closed.clear();
+	}
+
+	void CurveSet::reserve(int num_loops, int num_points) {
+		x.reserve(num_points);
+		y.reserve(num_points);
+		offsets.reserve(num_loops + 1);
+		closed.reserve(num_loops);
+	}
+
+	/**
+	 * Start a new loop. The following points are added to this loop.
+	 */
+	void CurveSet::addLoop(bool closed) {
+		offsets.push_back(offsets.back());
+		this->closed.push_back(closed);
+	}
+
+	/**
+	 * Add a point to the last loop.
+	 */
+	void CurveSet::addPoint(const glm::dvec2& pt) {
+		x.push_back(pt.x);
+		y.push_back(pt.y);
+		offsets.back()++;
+	}
+
+	/**
+	 * Rotate the points of the loop in place such that the point at first becomes the first point.
+	 */
+	void CurveSet::rotateLoop(int loop, int first) {
+		std::rotate(x.begin() + offsets[loop], x.begin() + offsets[loop] + first, x.begin() + offsets[loop + 1]);
+		std::rotate(y.begin() + offsets[loop], y.begin() + offsets[loop] + first, y.begin() + offsets[loop + 1]);
+	}
+
+}
\ No newline at end of file
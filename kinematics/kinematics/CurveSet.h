@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace kinematics {
+
+	/**
+	 * A set of polylines (loops) whose points are stored in contiguous x and y arrays.
+	 * The points of the i-th loop are [offsets[i], offsets[i + 1]), and closed[i] is true if the loop is closed.
+	 * Points are referred to either by the flat index or by (loop index, index in the loop).
+	 */
+	class CurveSet {
+	public:
+		std::vector<double> x;
+		std::vector<double> y;
+		std::vector<int> offsets;
+		std::vector<bool> closed;
+
+	public:
+		CurveSet() : offsets(1, 0) {}
+
+		int numLoops() const { return closed.size(); }
+		int numPoints() const { return x.size(); }
+		int size(int loop) const { return offsets[loop + 1] - offsets[loop]; }
+		bool empty() const { return x.size() == 0; }
+		glm::dvec2 point(int index) const { return glm::dvec2(x[index], y[index]); }
+		glm::dvec2 point(int loop, int index) const { return glm::dvec2(x[offsets[loop] + index], y[offsets[loop] + index]); }
+		glm::dvec2 front(int loop) const { return point(offsets[loop]); }
+		glm::dvec2 back(int loop) const { return point(offsets[loop + 1] - 1); }
+
+		void clear();
+		void reserve(int num_loops, int num_points);
+		void addLoop(bool closed = false);
+		void addPoint(const glm::dvec2& pt);
+		void rotateLoop(int loop, int first);
+	};
+
+}
\ No newline at end of file
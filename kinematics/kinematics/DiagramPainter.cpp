@@ -0,0 +1,146 @@
+#include "DiagramPainter.h"
+#include "Gear.h"
+#include "KinematicUtils.h"
+#include <QPolygon>
+
+namespace kinematics {
+
+	static void drawPinJoint(QPainter& painter, const Joint& joint, const QPointF& origin, float scale) {
+		painter.save();
+		painter.setPen(QPen(QColor(0, 0, 0), 1));
+		painter.setBrush(QBrush(QColor(255, 255, 255)));
+		painter.drawEllipse(QPoint(origin.x() + joint.pos.x * scale, origin.y() - joint.pos.y * scale), 5, 5);
+		painter.restore();
+	}
+
+	static void drawSliderHinge(QPainter& painter, const Joint& joint, const QPointF& origin, float scale) {
+		painter.save();
+		painter.setPen(QPen(QColor(0, 0, 0), 1));
+		painter.setBrush(QBrush(QColor(255, 255, 255)));
+
+		double theta = 0.0;
+		if (joint.links.size() > 0) {
+			for (int i = 0; i < joint.links[0]->joints.size(); ++i) {
+				if (joint.links[0]->joints[i]->id != joint.id && joint.links[0]->joints[i]->ground) {
+					theta = atan2(joint.links[0]->joints[i]->pos.y - joint.pos.y, joint.links[0]->joints[i]->pos.x - joint.pos.x);
+				}
+			}
+		}
+
+		painter.translate(origin.x() + joint.pos.x * scale, origin.y() - joint.pos.y * scale);
+		painter.rotate(-theta / M_PI * 180);
+		painter.drawRect(-20, -5, 40, 10);
+
+		painter.drawEllipse(QPoint(0, 0), 5, 5);
+		painter.restore();
+	}
+
+	static void drawGear(QPainter& painter, const Gear& gear, const QPointF& origin, float scale) {
+		const glm::dvec2& center = gear.center;
+		double radius = gear.radius;
+		double phase = gear.phase;
+
+		painter.save();
+		painter.setPen(QPen(QColor(0, 0, 0), 1));
+		painter.setBrush(QBrush(QColor(255, 255, 255, 0)));
+		painter.drawEllipse(QPoint(origin.x() + center.x * scale, origin.y() - center.y * scale), 5, 5);
+
+		painter.setBrush(QBrush(QColor(255, 255, 255)));
+
+		int num_split = radius * 0.6;
+		for (int i = 0; i < num_split; ++i) {
+			float theta1 = i * M_PI * 2.0 / num_split;
+			float theta2 = (i + 0.5) * M_PI * 2.0 / num_split;
+			float theta3 = (i + 1) * M_PI * 2.0 / num_split;
+
+			glm::vec2 p1 = center + glm::dvec2(cos(phase + theta1), sin(phase + theta1)) * (radius + 4);
+			glm::vec2 p2 = center + glm::dvec2(cos(phase + theta2), sin(phase + theta2)) * (radius + 4);
+			glm::vec2 p3 = center + glm::dvec2(cos(phase + theta2), sin(phase + theta2)) * radius;
+			glm::vec2 p4 = center + glm::dvec2(cos(phase + theta3), sin(phase + theta3)) * radius;
+			glm::vec2 p5 = center + glm::dvec2(cos(phase + theta3), sin(phase + theta3)) * (radius + 4);
+
+			painter.drawLine(origin.x() + p1.x * scale, origin.y() - p1.y * scale, origin.x() + p2.x * scale, origin.y() - p2.y * scale);
+			painter.drawLine(origin.x() + p2.x * scale, origin.y() - p2.y * scale, origin.x() + p3.x * scale, origin.y() - p3.y * scale);
+			painter.drawLine(origin.x() + p3.x * scale, origin.y() - p3.y * scale, origin.x() + p4.x * scale, origin.y() - p4.y * scale);
+			painter.drawLine(origin.x() + p4.x * scale, origin.y() - p4.y * scale, origin.x() + p5.x * scale, origin.y() - p5.y * scale);
+		}
+
+		painter.drawEllipse(QPointF(origin.x() + gear.pos.x * scale, origin.y() - gear.pos.y * scale), 5 * scale, 5 * scale);
+
+		painter.restore();
+	}
+
+	/**
+	 * Draw the joint according to its type.
+	 */
+	void draw(QPainter& painter, const Joint& joint, const QPointF& origin, float scale) {
+		if (joint.type == Joint::TYPE_PIN) {
+			drawPinJoint(painter, joint, origin, scale);
+		}
+		else if (joint.type == Joint::TYPE_SLIDER_HINGE) {
+			drawSliderHinge(painter, joint, origin, scale);
+		}
+		else if (joint.type == Joint::TYPE_GEAR) {
+			drawGear(painter, static_cast<const Gear&>(joint), origin, scale);
+		}
+	}
+
+	void draw(QPainter& painter, const Link& link, const QPointF& origin, float scale) {
+		painter.save();
+
+		if (link.driver) {
+			painter.setPen(QPen(QColor(0, 0, 0), 3));
+		}
+		else {
+			painter.setPen(QPen(QColor(90, 90, 90), 3));
+		}
+		painter.setBrush(QBrush(QColor(192, 192, 192, 64)));
+		QPolygon polygon;
+		for (int i = 0; i < link.joints.size(); ++i) {
+			polygon.append(QPoint(origin.x() + link.joints[i]->pos.x * scale, origin.y() - link.joints[i]->pos.y * scale));
+		}
+		painter.drawPolygon(polygon);
+
+		painter.restore();
+	}
+
+	void draw(QPainter& painter, const BodyGeometry& body, const QPointF& origin, float scale) {
+		painter.save();
+
+		painter.setPen(QPen(QColor(0, 0, 0), 1));
+		painter.setBrush(QBrush(QColor(0, 255, 0, 60)));
+		std::vector<glm::dvec2> actual_points = body.getActualPoints();
+		QPolygonF pts;
+		for (int k = 0; k < actual_points.size(); ++k) {
+			pts.push_back(QPointF(origin.x() + actual_points[k].x * scale, origin.y() - actual_points[k].y * scale));
+		}
+		painter.drawPolygon(pts);
+
+		painter.restore();
+	}
+
+	void draw(QPainter& painter, const KinematicDiagram& diagram, const QPointF& origin, float scale, bool show_bodies, bool show_links) {
+		if (show_bodies) {
+			for (int i = 0; i < diagram.bodies.size(); ++i) {
+				draw(painter, *diagram.bodies[i], origin, scale);
+			}
+		}
+
+		if (show_links) {
+			// draw links
+			for (auto it = diagram.links.begin(); it != diagram.links.end(); ++it) {
+				draw(painter, *it->second, origin, scale);
+			}
+
+			// draw joints
+			for (auto it = diagram.joints.begin(); it != diagram.joints.end(); ++it) {
+				draw(painter, *it->second, origin, scale);
+			}
+		}
+	}
+
+	void draw(QPainter& painter, const Kinematics& kinematics, const QPointF& origin, float scale) {
+		draw(painter, kinematics.diagram, origin, scale, kinematics.show_bodies, kinematics.show_links);
+	}
+
+}
\ No newline at end of file
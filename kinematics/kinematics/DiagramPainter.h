@@ -0,0 +1,18 @@
+#pragma once
+
+#include <QPainter>
+#include "Joint.h"
+#include "Link.h"
+#include "BodyGeometry.h"
+#include "KinematicDiagram.h"
+#include "Kinematics.h"
+
+namespace kinematics {
+
+	void draw(QPainter& painter, const Joint& joint, const QPointF& origin, float scale);
+	void draw(QPainter& painter, const Link& link, const QPointF& origin, float scale);
+	void draw(QPainter& painter, const BodyGeometry& body, const QPointF& origin, float scale);
+	void draw(QPainter& painter, const KinematicDiagram& diagram, const QPointF& origin, float scale, bool show_bodies, bool show_links);
+	void draw(QPainter& painter, const Kinematics& kinematics, const QPointF& origin, float scale);
+
+}
\ No newline at end of file
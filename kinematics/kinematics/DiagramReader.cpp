@@ -0,0 +1,167 @@
+#include "DiagramReader.h"
+#include "PinJoint.h"
+#include "SliderHinge.h"
+#include "Gear.h"
+#include <QFile>
+#include <QDomDocument>
+#include <QStringList>
+
+namespace kinematics {
+
+	/**
+	 * Create the joint of the XML element according to its type attribute.
+	 * A null pointer is returned for an unknown type.
+	 */
+	boost::shared_ptr<Joint> readJoint(const QDomElement& node) {
+		int id = node.attribute("id").toInt();
+		bool ground = node.attribute("ground").toLower() == "true";
+		glm::dvec2 pos(node.attribute("x").toDouble(), node.attribute("y").toDouble());
+
+		if (node.attribute("type") == "pin") {
+			return boost::shared_ptr<Joint>(new PinJoint(id, ground, pos));
+		}
+		else if (node.attribute("type") == "slider_hinge") {
+			return boost::shared_ptr<Joint>(new SliderHinge(id, ground, pos));
+		}
+		else if (node.attribute("type") == "gear") {
+			double radius = node.attribute("radius").toDouble();
+			double speed = node.attribute("speed").toDouble();
+			double phase = node.attribute("phase").toDouble();
+			return boost::shared_ptr<Joint>(new Gear(id, ground, pos, radius, speed, phase));
+		}
+		else {
+			return boost::shared_ptr<Joint>();
+		}
+	}
+
+	/**
+	 * Read the joints, the links, and the bodies of the diagram from the XML file.
+	 */
+	void loadDiagram(const QString& filename, KinematicDiagram& diagram) {
+		QFile file(filename);
+		if (!file.open(QFile::ReadOnly | QFile::Text)) throw "File cannot open.";
+
+		QDomDocument doc;
+		doc.setContent(&file);
+
+		QDomElement root = doc.documentElement();
+		if (root.tagName() != "design")	throw "Invalid file format.";
+
+		// clear the data
+		diagram.clear();
+
+		QDomNode node = root.firstChild();
+		while (!node.isNull()) {
+			if (node.toElement().tagName() == "joints") {
+				QDomNode joint_node = node.firstChild();
+				while (!joint_node.isNull()) {
+					if (joint_node.toElement().tagName() == "joint") {
+						// add a joint
+						boost::shared_ptr<Joint> joint = readJoint(joint_node.toElement());
+						if (joint) diagram.addJoint(joint);
+					}
+
+					joint_node = joint_node.nextSibling();
+				}
+			}
+			else if (node.toElement().tagName() == "links") {
+				QDomNode link_node = node.firstChild();
+				while (!link_node.isNull()) {
+					if (link_node.toElement().tagName() == "link") {
+						// add a link
+						bool driver = link_node.toElement().attribute("driver").toLower() == "true" ? true : false;
+						std::vector<boost::shared_ptr<Joint>> jts;
+						QStringList joint_list = link_node.toElement().attribute("joints").split(",");
+						for (int i = 0; i < joint_list.size(); ++i) {
+							jts.push_back(diagram.joints[joint_list[i].toInt()]);
+						}
+						diagram.addLink(driver, jts);
+					}
+
+					link_node = link_node.nextSibling();
+				}
+			}
+			else if (node.toElement().tagName() == "bodies") {
+				QDomNode body_node = node.firstChild();
+				while (!body_node.isNull()) {
+					if (body_node.toElement().tagName() == "body") {
+						// add a body
+						int id1 = body_node.toElement().attribute("id1").toInt();
+						int id2 = body_node.toElement().attribute("id2").toInt();
+
+						std::vector<glm::dvec2> points;
+						QDomNode point_node = body_node.firstChild();
+						while (!point_node.isNull()) {
+							if (point_node.toElement().tagName() == "point") {
+								double x = point_node.toElement().attribute("x").toDouble();
+								double y = point_node.toElement().attribute("y").toDouble();
+								points.push_back(glm::dvec2(x, y));
+							}
+
+							point_node = point_node.nextSibling();
+						}
+
+						diagram.addBody(diagram.joints[id1], diagram.joints[id2], points);
+					}
+
+					body_node = body_node.nextSibling();
+				}
+			}
+
+			node = node.nextSibling();
+		}
+
+		// initialize the adancency between rigid bodies
+		diagram.initialize();
+	}
+
+	void loadKinematics(const QString& filename, Kinematics& kinematics) {
+		kinematics.trace_end_effector.clear();
+
+		loadDiagram(filename, kinematics.diagram);
+	}
+
+	/**
+	 * Read the precision poses from the XML file with QDomDocument.
+	 * It reads the same files as the plain reader in PoseFile, and is kept for the GUI that already depends on QtXml.
+	 * An exception is thrown if the file cannot be read or does not have four poses.
+	 */
+	void readPoseFile(const QString& filename, std::vector<glm::dmat4x4>& poses) {
+		QFile file(filename);
+		if (!file.open(QFile::ReadOnly | QFile::Text)) throw "File cannot open.";
+
+		QDomDocument doc;
+		doc.setContent(&file);
+		QDomElement root = doc.documentElement();
+		if (root.tagName() != "poses")	throw "Invalid file format.";
+
+		poses.clear();
+
+		QDomNode node = root.firstChild();
+		while (!node.isNull()) {
+			if (node.toElement().tagName() == "pose") {
+				std::vector<glm::dvec2> pts;
+				QDomNode point_node = node.firstChild();
+				while (!point_node.isNull()) {
+					if (point_node.toElement().tagName() == "point") {
+						double x = point_node.toElement().attribute("x").toDouble();
+						double y = point_node.toElement().attribute("y").toDouble();
+						pts.push_back(glm::dvec2(x, y));
+					}
+					point_node = point_node.nextSibling();
+				}
+
+				if (pts.size() == 2) {
+					poses.push_back(poseFromPoints(pts[0], pts[1]));
+				}
+			}
+
+			node = node.nextSibling();
+		}
+
+		if (poses.size() != 4) {
+			throw "Invalid number of poses was specified.";
+		}
+	}
+
+}
\ No newline at end of file
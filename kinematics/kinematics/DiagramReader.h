@@ -0,0 +1,18 @@
+#pragma once
+
+#include <QString>
+#include <QDomElement>
+#include <boost/shared_ptr.hpp>
+#include "Joint.h"
+#include "KinematicDiagram.h"
+#include "Kinematics.h"
+#include "PoseFile.h"
+
+namespace kinematics {
+
+	boost::shared_ptr<Joint> readJoint(const QDomElement& node);
+	void loadDiagram(const QString& filename, KinematicDiagram& diagram);
+	void loadKinematics(const QString& filename, Kinematics& kinematics);
+	void readPoseFile(const QString& filename, std::vector<glm::dmat4x4>& poses);
+
+}
\ No newline at end of file
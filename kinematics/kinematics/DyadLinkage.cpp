@@ -0,0 +1,210 @@
+#include "DyadLinkage.h"
+#include "KinematicDiagram.h"
+#include "Joint.h"
+#include "Link.h"
+#include "KinematicUtils.h"
+#include "SimdLanes.h"
+
+namespace kinematics {
+
+	void DyadLinkageBlock::resize(int n) {
+		angle.resize(n);
+		valid.resize(n);
+		crank_x.resize(n);
+		crank_y.resize(n);
+		coupler_x.resize(n);
+		coupler_y.resize(n);
+	}
+
+	/**
+	 * Four-bar linkage with the ground pivots A0 and B0, the crank joint A, and the coupler joint B.
+	 * The branch is the one that B currently belongs to.
+	 */
+	DyadLinkage::DyadLinkage(const glm::dvec2& A0, const glm::dvec2& B0, const glm::dvec2& A, const glm::dvec2& B) : type(TYPE_FOURBAR), crank_joint(-1), coupler_joint(-1), A0(A0), B0(B0), branch(1) {
+		crank_length = glm::length(A - A0);
+		coupler_length = glm::length(B - A);
+		follower_length = glm::length(B - B0);
+
+		if (!setBranch(A, B)) type = TYPE_NONE;
+	}
+
+	/**
+	 * Recognize the diagram as a four-bar linkage or a slider-crank, i.e.,
+	 * a driver link between the ground pin joint A0 and the pin joint A,
+	 * a coupler link between A and B, and a follower link between B and the ground joint B0.
+	 * B is a pin joint for the four-bar, and a slider hinge whose line is its first link for the slider-crank.
+	 * The lengths are taken from the original shapes of the links, and the branch from the current positions.
+	 * If the diagram has any other joint or link, false is returned and the type is set to TYPE_NONE.
+	 */
+	bool DyadLinkage::recognize(KinematicDiagram& diagram) {
+		type = TYPE_NONE;
+		if (diagram.links.size() != 3) return false;
+
+		// find the driver link
+		Link* crank = NULL;
+		for (auto it = diagram.links.begin(); it != diagram.links.end(); ++it) {
+			if (!it->second->driver) continue;
+			if (crank != NULL) return false;
+			crank = it->second.get();
+		}
+		if (crank == NULL || crank->joints.size() != 2) return false;
+
+		Joint* a0 = crank->joints[0].get();
+		Joint* a = crank->joints[1].get();
+		if (!a0->ground) std::swap(a0, a);
+		if (!a0->ground || a0->type != Joint::TYPE_PIN || a->ground || a->type != Joint::TYPE_PIN || a->links.size() != 2) return false;
+
+		// the coupler link connects A and B
+		Link* coupler = (a->links[0].get() == crank) ? a->links[1].get() : a->links[0].get();
+		if (coupler == crank || coupler->joints.size() != 2) return false;
+		Joint* b = (coupler->joints[0].get() == a) ? coupler->joints[1].get() : coupler->joints[0].get();
+		if (b == a || b->ground || b->links.size() != 2) return false;
+
+		// the follower link connects B and B0
+		Link* follower = (b->links[0].get() == coupler) ? b->links[1].get() : b->links[0].get();
+		if (follower == crank || follower == coupler || follower->joints.size() != 2) return false;
+		Joint* b0 = (follower->joints[0].get() == b) ? follower->joints[1].get() : follower->joints[0].get();
+		if (b0 == b || !b0->ground) return false;
+
+		// no other joint is allowed
+		if (diagram.joints.size() != ((b0 == a0) ? 3 : 4)) return false;
+
+		int linkage_type;
+		if (b->type == Joint::TYPE_PIN) {
+			linkage_type = TYPE_FOURBAR;
+		}
+		else if (b->type == Joint::TYPE_SLIDER_HINGE) {
+			// the slider hinge slides along its first link
+			if (b->links[0].get() != follower) return false;
+			if (glm::length(b->pos - b0->pos) < TOL) return false;
+
+			dir = (b->pos - b0->pos) / glm::length(b->pos - b0->pos);
+			linkage_type = TYPE_SLIDER_CRANK;
+		}
+		else {
+			return false;
+		}
+
+		crank_joint = a->id;
+		coupler_joint = b->id;
+		A0 = a0->pos;
+		B0 = b0->pos;
+		crank_length = crank->getLengthAt(crank->indexOf(a0->id), crank->indexOf(a->id));
+		coupler_length = coupler->getLengthAt(coupler->indexOf(a->id), coupler->indexOf(b->id));
+		follower_length = follower->getLengthAt(follower->indexOf(b0->id), follower->indexOf(b->id));
+
+		type = linkage_type;
+		if (!setBranch(a->pos, b->pos)) {
+			type = TYPE_NONE;
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Choose the branch whose solution is closer to B when the crank joint is at A.
+	 * branch = 1 is int1 of circleCircleIntersection (four-bar) or circleLineIntersection (slider-crank), and -1 is int2.
+	 */
+	bool DyadLinkage::setBranch(const glm::dvec2& A, const glm::dvec2& B) {
+		glm::dvec2 int1, int2;
+		if (type == TYPE_FOURBAR) {
+			if (!circleCircleIntersection(A, coupler_length, B0, follower_length, int1, int2)) return false;
+		}
+		else if (type == TYPE_SLIDER_CRANK) {
+			if (!circleLineIntersection(A, coupler_length, B0, B0 + dir, int1, int2)) return false;
+		}
+		else {
+			return false;
+		}
+
+		branch = (glm::length(int1 - B) <= glm::length(int2 - B)) ? 1 : -1;
+		return true;
+	}
+
+	/**
+	 * Evaluate the lanes of the block starting at i.
+	 * This is the same computation as circleCircleIntersection and circleLineIntersection,
+	 * but the exceptional cases are recorded in the valid mask instead of returning early,
+	 * and the intersection is chosen by the branch instead of the previous position.
+	 */
+	template <class Lane>
+	void solveLanes(const DyadLinkage& linkage, const double* cos_angle, const double* sin_angle, DyadLinkageBlock& block, int i) {
+		typedef typename Lane::Mask Mask;
+
+		Lane Ax = Lane(linkage.A0.x) + Lane::load(cos_angle + i) * Lane(linkage.crank_length);
+		Lane Ay = Lane(linkage.A0.y) + Lane::load(sin_angle + i) * Lane(linkage.crank_length);
+		Lane r1(linkage.coupler_length);
+		Lane branch((double)linkage.branch);
+
+		if (linkage.type == DyadLinkage::TYPE_FOURBAR) {
+			// intersect the circle around A and the circle around B0
+			Lane r2(linkage.follower_length);
+			Lane dirx = Lane(linkage.B0.x) - Ax;
+			Lane diry = Lane(linkage.B0.y) - Ay;
+			Lane d = sqrt(dirx * dirx + diry * diry);
+			Lane sum = r1 + r2;
+			Lane diff = abs(r1 - r2);
+			Mask apart = (d > sum) | (d < diff);
+			Mask touching = apart & (d <= sum + Lane(TOL)) & (d > sum);
+			Mask inside = apart & !touching & (d >= diff - Lane(TOL)) & (d < diff);
+			Mask valid = (!apart) | touching | inside;
+			d = select(inside, diff, d);
+
+			Lane a = (r1 * r1 - r2 * r2 + d * d) / d / Lane(2.0);
+			Lane h = sqrt(max(Lane(0.0), r1 * r1 - a * a));
+			Lane perp_len = sqrt(diry * diry + dirx * dirx);
+			Lane px = diry / perp_len;
+			Lane py = -dirx / perp_len;
+			Lane bx = Ax + dirx * a / d;
+			Lane by = Ay + diry * a / d;
+			Lane tx = Ax + dirx / sum * r1;
+			Lane ty = Ay + diry / sum * r1;
+
+			select(touching, tx, bx + px * h * branch).store(&block.coupler_x[i]);
+			select(touching, ty, by + py * h * branch).store(&block.coupler_y[i]);
+			valid.store(&block.valid[i]);
+		}
+		else {
+			// intersect the circle around A and the line through B0 along dir
+			Lane nx(-linkage.dir.y);
+			Lane ny(linkage.dir.x);
+			Lane d = (Lane(linkage.B0.x) - Ax) * nx + (Lane(linkage.B0.y) - Ay) * ny;
+			Mask valid = !(abs(d) > r1);
+
+			Lane h = sqrt(max(Lane(0.0), r1 * r1 - d * d));
+			(Ax + nx * d - Lane(linkage.dir.x) * h * branch).store(&block.coupler_x[i]);
+			(Ay + ny * d - Lane(linkage.dir.y) * h * branch).store(&block.coupler_y[i]);
+			valid.store(&block.valid[i]);
+		}
+
+		Ax.store(&block.crank_x[i]);
+		Ay.store(&block.crank_y[i]);
+	}
+
+	/**
+	 * Calculate the positions of the crank joint and the coupler joint for all the crank angles of the block.
+	 * The lanes are evaluated with SIMD instructions if they are available, and the remainder with the scalar code.
+	 */
+	void DyadLinkage::solve(DyadLinkageBlock& block) const {
+		if (type == TYPE_NONE) throw "The linkage is not recognized.";
+
+		int n = block.size();
+		block.resize(n);
+
+		std::vector<double> cos_angle(n);
+		std::vector<double> sin_angle(n);
+		for (int i = 0; i < n; i++) {
+			cos_angle[i] = cos(block.angle[i]);
+			sin_angle[i] = sin(block.angle[i]);
+		}
+
+		int i = 0;
+		for (; i + DoubleLane::width <= n; i += DoubleLane::width) {
+			solveLanes<DoubleLane>(*this, cos_angle.data(), sin_angle.data(), block, i);
+		}
+		for (; i < n; i++) {
+			solveLanes<ScalarLane>(*this, cos_angle.data(), sin_angle.data(), block, i);
+		}
+	}
+
+}
\ No newline at end of file
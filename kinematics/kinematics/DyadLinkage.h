@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace kinematics {
+
+	class KinematicDiagram;
+
+	/**
+	 * The positions of the crank joint and the coupler joint for a block of crank angles in SoA buffers.
+	 * The angle is the direction of the crank from A0, and valid is 0 where the linkage cannot be assembled with the angle.
+	 */
+	class DyadLinkageBlock {
+	public:
+		std::vector<double> angle;
+		std::vector<unsigned char> valid;
+		std::vector<double> crank_x;
+		std::vector<double> crank_y;
+		std::vector<double> coupler_x;
+		std::vector<double> coupler_y;
+
+	public:
+		DyadLinkageBlock() {}
+
+		int size() const { return angle.size(); }
+		void resize(int n);
+	};
+
+	/**
+	 * Closed-form solver of the linkages that consist of a driving crank and one dyad,
+	 * i.e., the four-bar linkage and the slider-crank.
+	 * The crank rotates around the ground pivot A0, and the crank joint A drives the coupler joint B,
+	 * which is connected to the ground pivot B0 by the follower (four-bar),
+	 * or slides on the line through B0 along dir (slider-crank).
+	 * The branch is the assembly mode of the dyad, which is fixed to the current configuration when it is recognized,
+	 * so that the positions for any angle can be calculated independently without the previous position.
+	 */
+	class DyadLinkage {
+	public:
+		static enum { TYPE_NONE = 0, TYPE_FOURBAR, TYPE_SLIDER_CRANK };
+
+	public:
+		int type;
+		int crank_joint;
+		int coupler_joint;
+		glm::dvec2 A0;
+		glm::dvec2 B0;
+		glm::dvec2 dir;
+		double crank_length;
+		double coupler_length;
+		double follower_length;
+		int branch;
+
+	public:
+		DyadLinkage() : type(TYPE_NONE), crank_joint(-1), coupler_joint(-1), crank_length(0), coupler_length(0), follower_length(0), branch(1) {}
+		DyadLinkage(const glm::dvec2& A0, const glm::dvec2& B0, const glm::dvec2& A, const glm::dvec2& B);
+
+		bool recognize(KinematicDiagram& diagram);
+		void solve(DyadLinkageBlock& block) const;
+
+	private:
+		bool setBranch(const glm::dvec2& A, const glm::dvec2& B);
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include "ExtremePoseIndex.h"
+
+namespace kinematics {
+
+	ExtremePoseIndex::ExtremePoseIndex(const CurveSet& curve, const std::vector<std::vector<std::tuple<int, int, int>>>& extreme_poses) {
+		build(curve, extreme_poses);
+	}
+
+	/**
+	 * Build the index from the change points (index in the loop, pose1, pose2) of each loop, which are returned by findExtremePoses.
+	 * The change points of a loop are sorted by the index, and the first one is at the beginning of the loop.
+	 */
+	void ExtremePoseIndex::build(const CurveSet& curve, const std::vector<std::vector<std::tuple<int, int, int>>>& extreme_poses) {
+		starts.clear();
+		pose1.clear();
+		pose2.clear();
+
+		for (int i = 0; i < extreme_poses.size(); i++) {
+			for (int j = 0; j < extreme_poses[i].size(); j++) {
+				starts.push_back(curve.offsets[i] + std::get<0>(extreme_poses[i][j]));
+				pose1.push_back(std::get<1>(extreme_poses[i][j]));
+				pose2.push_back(std::get<2>(extreme_poses[i][j]));
+			}
+		}
+	}
+
+}
\ No newline at end of file
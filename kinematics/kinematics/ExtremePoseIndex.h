@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+#include <tuple>
+#include "CurveSet.h"
+
+namespace kinematics {
+
+	/**
+	 * Flat table of the extreme pose segments along a circle point curve.
+	 * The k-th segment covers the flat point indices [starts[k], starts[k + 1]) within its loop, and its extreme poses are
+	 * (pose1[k], pose2[k]), which are -1 if the segment has no extreme pose.
+	 * The segments come from the sampled special points, so they are used to show the extreme poses along the curve,
+	 * but they do not decide the branch defect of a crank, which is checked by checkBranchDefect.
+	 */
+	class ExtremePoseIndex {
+	public:
+		std::vector<int> starts;
+		std::vector<int> pose1;
+		std::vector<int> pose2;
+
+	public:
+		ExtremePoseIndex() {}
+		ExtremePoseIndex(const CurveSet& curve, const std::vector<std::vector<std::tuple<int, int, int>>>& extreme_poses);
+
+		void build(const CurveSet& curve, const std::vector<std::vector<std::tuple<int, int, int>>>& extreme_poses);
+		bool empty() const { return starts.size() == 0; }
+	};
+
+}
\ No newline at end of file
@@ -1,7 +1,6 @@
 #pragma once
 
 #include "Joint.h"
-#include <QDomDocument>
 
 namespace kinematics {
 
@@ -15,10 +14,9 @@ namespace kinematics {
 
 	public:
 		Gear(int id, bool ground, const glm::dvec2& pos, double radius, double speed, double phase);
-		Gear(QDomElement& node);
 
-		void draw(QPainter& painter, const QPointF& origin, float scale);
 		void stepForward(double step_size);
+		bool plan(SolveStep& step);
 		bool forwardKinematics();
 	};
 
@@ -1,5 +1,6 @@
 #include "Joint.h"
 #include "Link.h"
+#include "SolveSchedule.h"
 
 namespace kinematics {
 
@@ -17,4 +18,17 @@ namespace kinematics {
 		determined = true;
 	}
 
+	/**
+	 * Update the position of this joint.
+	 * Return true if the position is updated.
+	 * Return false if one of the positions of the parent nodes has not been updated yet.
+	 */
+	bool Joint::forwardKinematics() {
+		SolveStep step;
+		if (!plan(step)) return false;
+
+		step.solve();
+		return true;
+	}
+
 }
\ No newline at end of file
@@ -3,13 +3,12 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include <boost/shared_ptr.hpp>
-#include <QMap>
-#include <QPainter>
 #include <iostream>
 
 namespace kinematics {
 
 	class Link;
+	class SolveStep;
 
 	class Joint {
 	public:
@@ -26,9 +25,9 @@ namespace kinematics {
 		Joint();
 
 		void rotate(const glm::dvec2& rotation_center, double angle);
-		virtual void draw(QPainter& painter, const QPointF& origin, float scale) = 0;
 		virtual void stepForward(double step_size) = 0;
-		virtual bool forwardKinematics() = 0;
+		virtual bool plan(SolveStep& step) = 0;
+		virtual bool forwardKinematics();
 	};
 
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
 
 #include <vector>
 #include <boost/shared_ptr.hpp>
-#include <QMap>
+#include <map>
 
 #include "Joint.h"
 #include "Link.h"
@@ -12,15 +12,19 @@ namespace kinematics {
 
 	class KinematicDiagram {
 	public:
-		QMap<int, boost::shared_ptr<Joint>> joints;
-		QMap<int, boost::shared_ptr<Link>> links;
+		std::map<int, boost::shared_ptr<Joint>> joints;
+		std::map<int, boost::shared_ptr<Link>> links;
 		std::vector<boost::shared_ptr<BodyGeometry>> bodies;
 
+		/** Unique stamp of the topology and the shapes, which is renewed whenever they are changed. */
+		int revision;
+
 	public:
 		KinematicDiagram();
 		~KinematicDiagram();
 
 		KinematicDiagram clone() const;
+		void updateRevision();
 		void clear();
 		void initialize();
 		void addJoint(boost::shared_ptr<Joint> joint);
@@ -32,11 +36,8 @@ namespace kinematics {
 		boost::shared_ptr<Link> addLink(std::vector<boost::shared_ptr<Joint>> joints);
 		boost::shared_ptr<Link> addLink(bool driver, std::vector<boost::shared_ptr<Joint>> joints);
 		void addBody(boost::shared_ptr<Joint> joint1, boost::shared_ptr<Joint> joint2, std::vector<glm::dvec2> points);
-		void load(const QString& filename);
-		void save(const QString& filename);
 		void updateBodyAdjacency();
 		bool isCollided() const;
-		void draw(QPainter& painter, const QPointF& origin, float scale, bool show_bodies, bool show_links) const;
 	};
 
 }
\ No newline at end of file
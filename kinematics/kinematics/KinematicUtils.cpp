@@ -19,104 +19,101 @@ namespace kinematics {
 	 *     c1
 	 */
 	glm::dvec2 circleCircleIntersection(const glm::dvec2& center1, double radius1, const glm::dvec2& center2, double radius2) {
-		glm::dvec2 dir = center2 - center1;
-		double d = glm::length(dir);
-		if (d > radius1 + radius2 || d < abs(radius1 - radius2)) {
-			if (d <= radius1 + radius2 + TOL && d > radius1 + radius2) {
-				return center1 + dir / (radius1 + radius2) * radius1;
-				//d = radius1 + radius2;
-			}
-			else if (d >= abs(radius1 - radius2) - TOL && d < abs(radius1 - radius2)) {
-				d = abs(radius1 - radius2);
-			}
-			else {
-				throw "No intersection";
-			}
-		}
+		glm::dvec2 int1, int2;
+		if (!circleCircleIntersection(center1, radius1, center2, radius2, int1, int2)) throw "No intersection";
 
-		double a = (radius1 * radius1 - radius2 * radius2 + d * d) / d / 2.0;
-		double h = sqrt(radius1 * radius1 - a * a);
+		return int1;
+	}
 
-		glm::dvec2 perp(dir.y, -dir.x);
-		perp /= glm::length(perp);
+	glm::dvec2 circleCircleIntersection(const glm::dvec2& center1, double radius1, const glm::dvec2& center2, double radius2, const glm::dvec2& prev_int) {
+		glm::dvec2 int1, int2;
+		if (!circleCircleIntersection(center1, radius1, center2, radius2, int1, int2)) throw "No intersection";
 
-		return center1 + dir * a / d + perp * h;
+		if (glm::length(int1 - prev_int) <= glm::length(int2 - prev_int)) {
+			return int1;
+		}
+		else {
+			return int2;
+		}
 	}
 
-	glm::dvec2 circleCircleIntersection(const glm::dvec2& center1, double radius1, const glm::dvec2& center2, double radius2, const glm::dvec2& prev_int) {
+	/**
+	 * Find both intersections of two circles without throwing an exception.
+	 * int1 is the intersection on the right if you look at center 2 from center 1, and int2 is the one on the left.
+	 * Return false if the circles do not intersect.
+	 */
+	bool circleCircleIntersection(const glm::dvec2& center1, double radius1, const glm::dvec2& center2, double radius2, glm::dvec2& int1, glm::dvec2& int2) {
 		glm::dvec2 dir = center2 - center1;
 		double d = glm::length(dir);
 		if (d > radius1 + radius2 || d < abs(radius1 - radius2)) {
 			if (d <= radius1 + radius2 + TOL && d > radius1 + radius2) {
-				d = radius1 + radius2;
+				int1 = center1 + dir / (radius1 + radius2) * radius1;
+				int2 = int1;
+				return true;
 			}
 			else if (d >= abs(radius1 - radius2) - TOL && d < abs(radius1 - radius2)) {
 				d = abs(radius1 - radius2);
 			}
 			else {
-				throw "No intersection";
+				return false;
 			}
 		}
 
 		double a = (radius1 * radius1 - radius2 * radius2 + d * d) / d / 2.0;
-		double h = sqrt(radius1 * radius1 - a * a);
+		double h = sqrt(std::max(0.0, radius1 * radius1 - a * a));
 
 		glm::dvec2 perp(dir.y, -dir.x);
 		perp /= glm::length(perp);
 
-		glm::dvec2 result1 = center1 + dir * a / d + perp * h;
-		glm::dvec2 result2 = center1 + dir * a / d - perp * h;
-		if (glm::length(result1 - prev_int) <= glm::length(result2 - prev_int)) {
-			return result1;
-		}
-		else {
-			return result2;
-		}
+		int1 = center1 + dir * a / d + perp * h;
+		int2 = center1 + dir * a / d - perp * h;
+		return true;
 	}
 
 	/**
 	 * Find the intersection that is further from p1
 	 */
 	glm::dvec2 circleLineIntersection(const glm::dvec2& center, double radius, const glm::dvec2& p1, const glm::dvec2& p2) {
-		glm::dvec2 dir = p2 - p1;
-		dir /= glm::length(dir);
-
-		glm::dvec2 n(-dir.y, dir.x);
+		glm::dvec2 int1, int2;
+		if (!circleLineIntersection(center, radius, p1, p2, int1, int2)) throw "No intersection";
 
-		double d = glm::dot(p1 - center, n);
-		double h = sqrt(radius * radius - d * d);
-
-		if (abs(d) > radius) {
-			throw "No intersection";
-		}
-
-		return center + n * d - dir * h;
+		return int1;
 	}
 
 	/**
 	* Find the intersection that is closer to prev_int
 	*/
 	glm::dvec2 circleLineIntersection(const glm::dvec2& center, double radius, const glm::dvec2& p1, const glm::dvec2& p2, const glm::dvec2& prev_int) {
+		glm::dvec2 int1, int2;
+		if (!circleLineIntersection(center, radius, p1, p2, int1, int2)) throw "No intersection";
+
+		if (glm::length(int2 - prev_int) <= glm::length(int1 - prev_int)) {
+			return int2;
+		}
+		else {
+			return int1;
+		}
+	}
+
+	/**
+	 * Find both intersections of a circle and a line without throwing an exception.
+	 * int1 is the intersection that is further from p1, and int2 is the other one.
+	 * Return false if the circle and the line do not intersect.
+	 */
+	bool circleLineIntersection(const glm::dvec2& center, double radius, const glm::dvec2& p1, const glm::dvec2& p2, glm::dvec2& int1, glm::dvec2& int2) {
 		glm::dvec2 dir = p2 - p1;
 		dir /= glm::length(dir);
 
 		glm::dvec2 n(-dir.y, dir.x);
 
 		double d = glm::dot(p1 - center, n);
-		double h = sqrt(radius * radius - d * d);
+		if (abs(d) > radius) return false;
 
-		if (abs(d) > radius) {
-			throw "No intersection";
-		}
+		double h = sqrt(radius * radius - d * d);
 
-		glm::dvec2 result1 = center + n * d + dir * h;
-		glm::dvec2 result2 = center + n * d - dir * h;
-		if (glm::length(result1 - prev_int) <= glm::length(result2 - prev_int)) {
-			return result1;
-		}
-		else {
-			return result2;
-		}
+		int1 = center + n * d - dir * h;
+		int2 = center + n * d + dir * h;
+		return true;
 	}
 
 	bool polygonPolygonIntersection(const std::vector<glm::dvec2>& polygon1, const std::vector<glm::dvec2>& polygon2) {
@@ -206,9 +203,16 @@ namespace kinematics {
 	* Also, p1 should be close to prev_pos, p2 should be close to prev_pos2, p3 should be close to prev_pos3.
 	*/
 	glm::dvec2 threeLengths(const glm::dvec2& a, double l0, const glm::dvec2& b, double l1, const glm::dvec2& c, double l2, double r0, double r1, double r2, const glm::dvec2& prev_pos, const glm::dvec2& prev_pos2, const glm::dvec2& prev_pos3) {
-		double min_dist = std::numeric_limits<double>::max();
-		glm::dvec2 best_pos;
+		glm::dvec2 pos;
+		if (!threeLengths(a, l0, b, l1, c, l2, r0, r1, r2, prev_pos, prev_pos2, prev_pos3, pos)) throw "No solution";
 
+		return pos;
+	}
+
+	/**
+	* Same as above, but return false instead of throwing an exception if there is no solution.
+	*/
+	bool threeLengths(const glm::dvec2& a, double l0, const glm::dvec2& b, double l1, const glm::dvec2& c, double l2, double r0, double r1, double r2, const glm::dvec2& prev_pos, const glm::dvec2& prev_pos2, const glm::dvec2& prev_pos3, glm::dvec2& pos) {
 		double theta0 = 0;
 		double theta1 = M_PI * 2;
 		double delta_theta = 0.01;
@@ -221,15 +225,11 @@ namespace kinematics {
 			delta_theta *= 0.1;
 		}
 
-		glm::dvec2 pos(a.x + l0 * cos(best_theta), a.y + l0 * sin(best_theta));
+		pos = glm::dvec2(a.x + l0 * cos(best_theta), a.y + l0 * sin(best_theta));
 
 		double dist = std::numeric_limits<double>::max();
-		try {
-			glm::dvec2 P1a = circleCircleIntersection(pos, r0, b, l1);// , prev_pos2);
-			glm::dvec2 P1b = circleCircleIntersection(b, l1, pos, r0);
-			glm::dvec2 P2a = circleCircleIntersection(pos, r1, c, l2);// , prev_pos3);
-			glm::dvec2 P2b = circleCircleIntersection(c, l2, pos, r1);
-
+		glm::dvec2 P1a, P1b, P2a, P2b;
+		if (circleCircleIntersection(pos, r0, b, l1, P1a, P1b) && circleCircleIntersection(pos, r1, c, l2, P2a, P2b)) {
 			if (glm::length(P1a - prev_pos2) < l1 * 0.5 && glm::length(P2a - prev_pos3) < l2 * 0.5) {
 				dist = std::min(dist, std::abs(glm::length(P1a - P2a) - r2));
 			}
@@ -243,12 +243,8 @@ namespace kinematics {
 				dist = std::min(dist, std::abs(glm::length(P1b - P2b) - r2));
 			}
 		}
-		catch (char* ex) {
-		}
 
-		if (dist > 0.001) throw "No solution";
-
-		return pos;
+		return dist <= 0.001;
 	}
 
 	double threeLengths(const glm::dvec2& a, double l0, const glm::dvec2& b, double l1, const glm::dvec2& c, double l2, double r0, double r1, double r2, const glm::dvec2& prev_pos, const glm::dvec2& prev_pos2, const glm::dvec2& prev_pos3, double theta0, double theta1, double delta_theta) {
@@ -265,40 +261,35 @@ namespace kinematics {
 			glm::dvec2 pos(a.x + l0 * cos(theta), a.y + l0 * sin(theta));
 			if (glm::length(pos - prev_pos) > l0 * 0.5) continue;
 
-			try {
-				glm::dvec2 P1a = circleCircleIntersection(pos, r0, b, l1);// , prev_pos2);
-				glm::dvec2 P1b = circleCircleIntersection(b, l1, pos, r0);
-				glm::dvec2 P2a = circleCircleIntersection(pos, r1, c, l2);// , prev_pos3);
-				glm::dvec2 P2b = circleCircleIntersection(c, l2, pos, r1);
-
-				// calculate angle sign of b-P1-pos
-				bool sign2a = crossProduct(P1a - b, pos - P1a) >= 0 ? true : false;
-				bool sign2b = crossProduct(P1b - b, pos - P1b) >= 0 ? true : false;
-
-				// calculate angle sign of c-P2-pos
-				bool sign3a = crossProduct(P2a - c, pos - P2a) >= 0 ? true : false;
-				bool sign3b = crossProduct(P2b - c, pos - P2b) >= 0 ? true : false;
-
-				double dist = std::numeric_limits<double>::max();
-				if (glm::length(P1a - prev_pos2) < l1 * 0.5 && glm::length(P2a - prev_pos3) < l2 * 0.5 && sign2a == prev_sign2 || sign3a == prev_sign3) {
-					dist = std::min(dist, std::abs(glm::length(P1a - P2a) - r2));
-				}
-				if (glm::length(P1a - prev_pos2) < l1 * 0.5 && glm::length(P2b - prev_pos3) < l2 * 0.5 && sign2a == prev_sign2 || sign3b == prev_sign3) {
-					dist = std::min(dist, std::abs(glm::length(P1a - P2b) - r2));
-				}
-				if (glm::length(P1b - prev_pos2) < l1 * 0.5 && glm::length(P2a - prev_pos3) < l2 * 0.5 && sign2b == prev_sign2 || sign3a == prev_sign3) {
-					dist = std::min(dist, std::abs(glm::length(P1b - P2a) - r2));
-				}
-				if (glm::length(P1b - prev_pos2) < l1 * 0.5 && glm::length(P2b - prev_pos3) < l2 * 0.5 && sign2b == prev_sign2 || sign3b == prev_sign3) {
-					dist = std::min(dist, std::abs(glm::length(P1b - P2b) - r2));
-				}
-
-				if (dist < min_dist) {
-					min_dist = dist;
-					best_theta = theta;
-				}
+			glm::dvec2 P1a, P1b, P2a, P2b;
+			if (!circleCircleIntersection(pos, r0, b, l1, P1a, P1b)) continue;
+			if (!circleCircleIntersection(pos, r1, c, l2, P2a, P2b)) continue;
+
+			// calculate angle sign of b-P1-pos
+			bool sign2a = crossProduct(P1a - b, pos - P1a) >= 0 ? true : false;
+			bool sign2b = crossProduct(P1b - b, pos - P1b) >= 0 ? true : false;
+
+			// calculate angle sign of c-P2-pos
+			bool sign3a = crossProduct(P2a - c, pos - P2a) >= 0 ? true : false;
+			bool sign3b = crossProduct(P2b - c, pos - P2b) >= 0 ? true : false;
+
+			double dist = std::numeric_limits<double>::max();
+			if (glm::length(P1a - prev_pos2) < l1 * 0.5 && glm::length(P2a - prev_pos3) < l2 * 0.5 && sign2a == prev_sign2 || sign3a == prev_sign3) {
+				dist = std::min(dist, std::abs(glm::length(P1a - P2a) - r2));
+			}
+			if (glm::length(P1a - prev_pos2) < l1 * 0.5 && glm::length(P2b - prev_pos3) < l2 * 0.5 && sign2a == prev_sign2 || sign3b == prev_sign3) {
+				dist = std::min(dist, std::abs(glm::length(P1a - P2b) - r2));
+			}
+			if (glm::length(P1b - prev_pos2) < l1 * 0.5 && glm::length(P2a - prev_pos3) < l2 * 0.5 && sign2b == prev_sign2 || sign3a == prev_sign3) {
+				dist = std::min(dist, std::abs(glm::length(P1b - P2a) - r2));
+			}
+			if (glm::length(P1b - prev_pos2) < l1 * 0.5 && glm::length(P2b - prev_pos3) < l2 * 0.5 && sign2b == prev_sign2 || sign3b == prev_sign3) {
+				dist = std::min(dist, std::abs(glm::length(P1b - P2b) - r2));
 			}
-			catch (char* ex) {
+
+			if (dist < min_dist) {
+				min_dist = dist;
+				best_theta = theta;
 			}
 		}
 
@@ -319,6 +310,18 @@ namespace kinematics {
 		return v1.x * v2.y - v1.y * v2.x;
 	}
 
+	/**
+	 * Calculate the distance from point p to the line segment a-b.
+	 */
+	double pointSegmentDistance(const glm::dvec2& p, const glm::dvec2& a, const glm::dvec2& b) {
+		glm::dvec2 v = b - a;
+		double len2 = glm::dot(v, v);
+		if (len2 == 0.0) return glm::length(p - a);
+
+		double t = std::min(std::max(glm::dot(p - a, v) / len2, 0.0), 1.0);
+		return glm::length(p - (a + v * t));
+	}
+
 	/**
 	* Given that point p1 goes to p2, and the point q1 goes to q2,
 	* return the matrix for this transformation.
@@ -331,6 +334,25 @@ namespace kinematics {
 		return glm::dmat3x3({ cos(theta), sin(theta), 0, -sin(theta), cos(theta), 0, -p1.x * cos(theta) + p1.y * sin(theta) + p2.x, -p1.x * sin(theta) - p1.y * cos(theta) + p2.y, 1 });
 	}
 
+	/**
+	 * Return the rigid transformation that maps orig_p0 to p0 and rotates the direction from orig_p0 to orig_p1
+	 * to the direction from p0 to p1.
+	 */
+	glm::dmat3x2 rigidTransform(const glm::dvec2& orig_p0, const glm::dvec2& orig_p1, const glm::dvec2& p0, const glm::dvec2& p1) {
+		double num = (p1.y - p0.y) * (orig_p1.x - orig_p0.x) - (p1.x - p0.x) * (orig_p1.y - orig_p0.y);
+		double den = (p1.x - p0.x) * (orig_p1.x - orig_p0.x) + (p1.y - p0.y) * (orig_p1.y - orig_p0.y);
+		double theta = atan2(num, den);
+		glm::dmat3x2 ret;
+		ret[0][0] = cos(theta);
+		ret[0][1] = sin(theta);
+		ret[1][0] = -sin(theta);
+		ret[1][1] = cos(theta);
+		ret[2][0] = -cos(theta) * orig_p0.x + sin(theta) * orig_p0.y + p0.x;
+		ret[2][1] = -sin(theta) * orig_p0.x - cos(theta) * orig_p0.y + p0.y;
+
+		return ret;
+	}
+
 	double area(const std::vector<glm::dvec2>& points) {
 		polygon poly = points;
 		boost::geometry::correct(poly);
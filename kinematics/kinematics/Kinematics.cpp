@@ -1,9 +1,5 @@
 #include "Kinematics.h"
 #include <iostream>
-#include <QFile>
-#include <QDomDocument>
-#include <QTextStream>
-#include <QDate>
 #include "PinJoint.h"
 #include "SliderHinge.h"
 #include "Gear.h"
@@ -20,74 +16,35 @@ namespace kinematics {
 
 	void Kinematics::clear() {
 		diagram.clear();
+		compact.clear();
 		trace_end_effector.clear();
 	}
 
-	void Kinematics::load(const QString& filename) {
-		trace_end_effector.clear();
-
-		diagram.load(filename);
-
-		//trace_end_effector.resize(assemblies.size());
-	}
-
-	void Kinematics::save(const QString& filename) {
-		diagram.save(filename);
-	}
-
+	/**
+	 * Update the positions of the joints whose position has not been determined
+	 * by replaying the steps compiled in the compact representation of the diagram.
+	 * This works only on the compact representation after its drivers are stepped,
+	 * so it is called only by stepForward() and stepBackward(), which also store the result into the diagram.
+	 */
 	void Kinematics::forwardKinematics(bool collision_check) {
-		std::list<boost::shared_ptr<Joint>> queue;
-
-		// put the joints whose position has not been determined into the queue
-		for (auto it = diagram.joints.begin(); it != diagram.joints.end(); ++it) {
-			if (!diagram.joints[it.key()]->determined) queue.push_back(diagram.joints[it.key()]);
-		}
+		compact.forwardKinematics();
 
-		int count = 0;
-		while (!queue.empty()) {
-			boost::shared_ptr<Joint> joint = queue.front();
-			queue.pop_front();
-
-			if (!joint->forwardKinematics()) {
-				queue.push_back(joint);
-			}
-
-			count++;
-			if (count > 1000) {
-				throw "infinite loop is detected.";
-			}
-		}
-
-		if (collision_check && isCollided()) {
+		if (collision_check && compact.isCollided()) {
 			throw "collision is detected.";
 		}
 	}
 
 	void Kinematics::stepForward(bool collision_check, bool need_recovery_for_collision) {
+		// rebuild the compact representation if the diagram has been changed
+		compact.update(diagram);
+
 		// save the current state
-		KinematicDiagram prev_state;
 		if (need_recovery_for_collision) {
-			prev_state = diagram.clone();
+			compact.saveState(saved_state);
 		}
 
-		// clear the determined flag of joints
-		for (auto it = diagram.joints.begin(); it != diagram.joints.end(); ++it) {
-			if (diagram.joints[it.key()]->ground) {
-				diagram.joints[it.key()]->determined = true;
-			}
-			else {
-				diagram.joints[it.key()]->determined = false;
-			}
-		}
-
-		// update the positions of the joints by the driver
-		bool driver_exist = false;
-		for (auto it = diagram.joints.begin(); it != diagram.joints.end(); ++it) {
-			if (diagram.joints[it.key()]->ground) {
-				driver_exist = true;
-				diagram.joints[it.key()]->stepForward(simulation_speed);
-			}
-		}
+		// clear the determined flag of joints, and update the positions of the joints by the driver
+		bool driver_exist = compact.stepDrivers(simulation_speed);
 
 		if (driver_exist) {
 			try {
@@ -95,38 +52,28 @@ namespace kinematics {
 			}
 			catch (char* ex) {
 				if (need_recovery_for_collision) {
-					diagram = prev_state.clone();
+					compact.restoreState(saved_state);
 				}
+				compact.store();
 				throw ex;
 			}
 		}
+
+		// update the joints and the links of the diagram
+		compact.store();
 	}
 
 	void Kinematics::stepBackward(bool collision_check, bool need_recovery_for_collision) {
+		// rebuild the compact representation if the diagram has been changed
+		compact.update(diagram);
+
 		// save the current state
-		KinematicDiagram prev_state;
 		if (need_recovery_for_collision) {
-			prev_state = diagram.clone();
+			compact.saveState(saved_state);
 		}
 
-		// clear the determined flag of joints
-		for (auto it = diagram.joints.begin(); it != diagram.joints.end(); ++it) {
-			if (diagram.joints[it.key()]->ground) {
-				diagram.joints[it.key()]->determined = true;
-			}
-			else {
-				diagram.joints[it.key()]->determined = false;
-			}
-		}
-
-		// update the positions of the joints by the driver
-		bool driver_exist = false;
-		for (auto it = diagram.joints.begin(); it != diagram.joints.end(); ++it) {
-			if (diagram.joints[it.key()]->ground) {
-				driver_exist = true;
-				diagram.joints[it.key()]->stepForward(-simulation_speed);
-			}
-		}
+		// clear the determined flag of joints, and update the positions of the joints by the driver
+		bool driver_exist = compact.stepDrivers(-simulation_speed);
 
 		if (driver_exist) {
 			try {
@@ -134,19 +81,33 @@ namespace kinematics {
 			}
 			catch (char* ex) {
 				if (need_recovery_for_collision) {
-					diagram = prev_state.clone();
+					compact.restoreState(saved_state);
 				}
+				compact.store();
 				throw ex;
 			}
 		}
+
+		// update the joints and the links of the diagram
+		compact.store();
 	}
 
-	bool Kinematics::isCollided() {
-		return diagram.isCollided();
+	/**
+	 * Calculate the positions of the crank joint and the coupler joint for all the crank angles of the block
+	 * by the closed-form solver, without changing the diagram.
+	 * The branch is the one of the configuration when the diagram was built or last changed, and no collision is checked.
+	 * If the diagram is not a four-bar linkage or a slider-crank, false is returned.
+	 */
+	bool Kinematics::sweep(DyadLinkageBlock& block) {
+		compact.update(diagram);
+		if (compact.linkage.type == DyadLinkage::TYPE_NONE) return false;
+
+		compact.linkage.solve(block);
+		return true;
 	}
 
-	void Kinematics::draw(QPainter& painter, const QPointF& origin, float scale) const {
-		diagram.draw(painter, origin, scale, show_bodies, show_links);
+	bool Kinematics::isCollided() {
+		return diagram.isCollided();
 	}
 
 	void Kinematics::speedUp() {
@@ -1,16 +1,14 @@
 #pragma once
 
-#include <QPainter>
-#include <QPoint>
 #include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <boost/shared_ptr.hpp>
-#include <QMap>
 #include "Joint.h"
 #include "Link.h"
 #include "BodyGeometry.h"
 #include "KinematicDiagram.h"
+#include "CompactDiagram.h"
 
 namespace kinematics {
 	
@@ -18,6 +16,8 @@ namespace kinematics {
 	public:
 		KinematicDiagram diagram;
 		std::vector<std::vector<glm::vec2>> trace_end_effector;
+		std::vector<double> saved_state;
+		CompactDiagram compact;
 
 		double simulation_speed;
 		bool show_assemblies;
@@ -28,19 +28,19 @@ namespace kinematics {
 		Kinematics(double simulation_speed = 0.01);
 
 		void clear();
-		void load(const QString& filename);
-		void save(const QString& filename);
-		void forwardKinematics(bool collision_check);
 		void stepForward(bool collision_check, bool need_recovery_for_collision = true);
 		void stepBackward(bool collision_check, bool need_recovery_for_collision = true);
+		bool sweep(DyadLinkageBlock& block);
 		bool isCollided();
-		void draw(QPainter& painter, const QPointF& origin, float scale) const;
 		void speedUp();
 		void speedDown();
 		void invertSpeed();
 		void showAssemblies(bool flag);
 		void showLinks(bool flag);
 		void showBodies(bool flag);
+
+	private:
+		void forwardKinematics(bool collision_check);
 	};
 
 }
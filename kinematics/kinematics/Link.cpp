@@ -1,6 +1,6 @@
 #include "Link.h"
 #include "Joint.h"
-#include <QPolygon>
+#include "KinematicUtils.h"
 
 namespace kinematics {
 
@@ -8,12 +8,14 @@ namespace kinematics {
 		this->id = id;
 		this->angle = 0;
 		this->driver = false;
+		this->tables_updated = false;
 	}
 
 	Link::Link(int id, bool driver) {
 		this->id = id;
 		this->angle = 0;
 		this->driver = driver;
+		this->tables_updated = false;
 	}
 
 	bool Link::isDetermined() {
@@ -38,6 +40,7 @@ namespace kinematics {
 
 	void Link::addJoint(boost::shared_ptr<Joint> joint) {
 		joints.push_back(joint);
+		tables_updated = false;
 		if (joints.size() == 2) {
 			// initialize the link angle
 			angle = atan2(joints[1]->pos.y - joints[0]->pos.y, joints[1]->pos.x - joints[0]->pos.x);
@@ -51,34 +54,94 @@ namespace kinematics {
 		this->angle += angle;
 	}
 
+	/**
+	 * Replace the original shape. The dense tables are rebuilt when they are used next time.
+	 */
+	void Link::setOriginalShape(const std::map<int, glm::dvec2>& original_shape) {
+		this->original_shape = original_shape;
+		tables_updated = false;
+	}
+
+	/**
+	 * Set the original position of the joint. The dense tables are rebuilt when they are used next time.
+	 */
+	void Link::setOriginalPosition(int joint_id, const glm::dvec2& pos) {
+		original_shape[joint_id] = pos;
+		tables_updated = false;
+	}
+
+	/**
+	 * Build the dense tables of the original shape, i.e., the original positions of the joints in the order of joints,
+	 * and the matrix of the lengths between them, so that the simulation does not look up original_shape.
+	 * This is called by KinematicDiagram::initialize(), and the tables are also rebuilt when they are used
+	 * after a joint is added or the original shape is set.
+	 */
+	void Link::updateTables() {
+		shape.resize(joints.size());
+		for (int i = 0; i < joints.size(); ++i) {
+			shape[i] = original_shape[joints[i]->id];
+		}
+
+		lengths.resize(joints.size() * joints.size());
+		for (int i = 0; i < joints.size(); ++i) {
+			for (int j = 0; j < joints.size(); ++j) {
+				lengths[i * joints.size() + j] = glm::length(shape[i] - shape[j]);
+			}
+		}
+		tables_updated = true;
+	}
+
+	/**
+	 * Return the index of the joint in this link, or -1 if the joint does not belong to this link.
+	 */
+	int Link::indexOf(int joint_id) const {
+		for (int i = 0; i < joints.size(); ++i) {
+			if (joints[i]->id == joint_id) return i;
+		}
+		return -1;
+	}
+
 	double Link::getLength(int joint_id1, int joint_id2) {
 		return glm::length(original_shape[joint_id1] - original_shape[joint_id2]);
 	}
 
+	/**
+	 * Return the length between joints[index1] and joints[index2] in the original shape.
+	 */
+	double Link::getLengthAt(int index1, int index2) {
+		if (!hasTables()) updateTables();
+
+		return lengths[index1 * joints.size() + index2];
+	}
+
 	glm::dmat3x2 Link::getTransformMatrix() {
-		std::vector<glm::dvec2> orig_p;
-		std::vector<glm::dvec2> p;
+		int index1 = -1;
+		int index2 = -1;
 		for (int i = 0; i < joints.size(); ++i) {
 			if (joints[i]->determined) {
-				p.push_back(joints[i]->pos);
-				orig_p.push_back(original_shape[joints[i]->id]);
+				if (index1 < 0) {
+					index1 = i;
+				}
+				else {
+					index2 = i;
+					break;
+				}
 			}
 		}
 
-		if (p.size() < 2) throw "Undetermined";
+		if (index2 < 0) throw "Undetermined";
 
-		double num = (p[1].y - p[0].y) * (orig_p[1].x - orig_p[0].x) - (p[1].x - p[0].x) * (orig_p[1].y - orig_p[0].y);
-		double den = (p[1].x - p[0].x) * (orig_p[1].x - orig_p[0].x) + (p[1].y - p[0].y) * (orig_p[1].y - orig_p[0].y);
-		double theta = atan2(num, den);
-		glm::dmat3x2 ret;
-		ret[0][0] = cos(theta);
-		ret[0][1] = sin(theta);
-		ret[1][0] = -sin(theta);
-		ret[1][1] = cos(theta);
-		ret[2][0] = -cos(theta) * orig_p[0].x + sin(theta) * orig_p[0].y + p[0].x;
-		ret[2][1] = -sin(theta) * orig_p[0].x - cos(theta) * orig_p[0].y + p[0].y;
+		return getTransformMatrix(index1, index2);
+	}
 
-		return ret;
+	/**
+	 * Return the rigid transformation that maps the original positions of joints[index1] and joints[index2]
+	 * to their current positions.
+	 */
+	glm::dmat3x2 Link::getTransformMatrix(int index1, int index2) {
+		if (!hasTables()) updateTables();
+
+		return rigidTransform(shape[index1], shape[index2], joints[index1]->pos, joints[index2]->pos);
 	}
 
 	glm::dvec2 Link::transformByDeterminedJoints(int joint_id) {
@@ -87,23 +150,14 @@ namespace kinematics {
 		return mat * glm::dvec3(original_shape[joint_id], 1);
 	}
 
-	void Link::draw(QPainter& painter, const QPointF& origin, float scale) {
-		painter.save();
-
-		if (driver) {
-			painter.setPen(QPen(QColor(0, 0, 0), 3));
-		}
-		else {
-			painter.setPen(QPen(QColor(90, 90, 90), 3));
-		}
-		painter.setBrush(QBrush(QColor(192, 192, 192, 64)));
-		QPolygon polygon;
-		for (int i = 0; i < joints.size(); ++i) {
-			polygon.append(QPoint(origin.x() + joints[i]->pos.x * scale, origin.y() - joints[i]->pos.y * scale));
-		}
-		painter.drawPolygon(polygon);
+	/**
+	 * Return the position of joints[index] transformed with the link by joints[index1] and joints[index2].
+	 * This does not allocate any memory nor look up original_shape.
+	 */
+	glm::dvec2 Link::transformByJoints(int index1, int index2, int index) {
+		glm::dmat3x2 mat = getTransformMatrix(index1, index2);
 
-		painter.restore();
+		return mat * glm::dvec3(shape[index], 1);
 	}
 
 }
\ No newline at end of file
@@ -3,8 +3,7 @@
 #include <glm/glm.hpp>
 #include <boost/shared_ptr.hpp>
 #include <vector>
-#include <QMap>
-#include <QPainter>
+#include <map>
 
 namespace kinematics {
 
@@ -14,10 +13,16 @@ namespace kinematics {
 	public:
 		int id;
 		std::vector<boost::shared_ptr<Joint>> joints;
-		QMap<int, glm::dvec2> original_shape;
+		std::vector<glm::dvec2> shape;
+		std::vector<double> lengths;
 		double angle;
 		bool driver;
 
+	private:
+		// the original shape is changed only by the setters, which mark the dense tables out of date
+		std::map<int, glm::dvec2> original_shape;
+		bool tables_updated;
+
 	public:
 		Link(int id);
 		Link(int id, bool driver);
@@ -26,11 +31,19 @@ namespace kinematics {
 		bool isGrounded();
 		void addJoint(boost::shared_ptr<Joint> joint);
 		void rotate(const glm::dvec2& rotation_center, double angle);
+		const std::map<int, glm::dvec2>& getOriginalShape() const { return original_shape; }
+		void setOriginalShape(const std::map<int, glm::dvec2>& original_shape);
+		void setOriginalPosition(int joint_id, const glm::dvec2& pos);
+		void updateTables();
+		bool hasTables() const { return tables_updated && shape.size() == joints.size(); }
+		int indexOf(int joint_id) const;
 		double getLength(int joint_id1, int joint_id2);
+		double getLengthAt(int index1, int index2);
 		glm::dmat3x2 getTransformMatrix();
+		glm::dmat3x2 getTransformMatrix(int index1, int index2);
 		glm::dvec2 transformByDeterminedJoints(int joint_id);
+		glm::dvec2 transformByJoints(int index1, int index2, int index);
 		glm::dvec2 forwardKinematics(glm::dvec2& start_pos);
-		void draw(QPainter& painter, const QPointF& origin, float scale);
 	};
 
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "PinJoint.h"
 #include "Link.h"
 #include "KinematicUtils.h"
+#include "SolveSchedule.h"
 
 namespace kinematics {
 
@@ -11,21 +12,6 @@ namespace kinematics {
 		this->pos = pos;
 	}
 
-	PinJoint::PinJoint(QDomElement& node) : Joint() {
-		id = node.attribute("id").toInt();
-		this->type = TYPE_PIN;
-		this->ground = node.attribute("ground").toLower() == "true";
-		pos.x = node.attribute("x").toDouble();
-		pos.y = node.attribute("y").toDouble();
-	}
-
-	void PinJoint::draw(QPainter& painter, const QPointF& origin, float scale) {
-		painter.save();
-		painter.setPen(QPen(QColor(0, 0, 0), 1));
-		painter.setBrush(QBrush(QColor(255, 255, 255)));
-		painter.drawEllipse(QPoint(origin.x() + pos.x * scale, origin.y() - pos.y * scale), 5, 5);
-		painter.restore();
-	}
 
 	void PinJoint::stepForward(double step_size) {
 		if (ground) {
@@ -39,13 +25,15 @@ namespace kinematics {
 	}
 
 	/**
-	 * Update the position of this joint.
-	 * Return true if the position is updated.
+	 * Choose the primitive that determines the position of this joint based on its neighbors
+	 * whose position has already been determined, and store it in the step.
+	 * The positions are not changed, so the primitive can be replayed later by SolveStep::solve().
+	 * Return true if the position can be determined.
 	 * Return false if one of the positions of the parent nodes has not been updated yet.
 	 */
-	bool PinJoint::forwardKinematics() {
+	bool PinJoint::plan(SolveStep& step) {
 		if (links.size() == 0) {
-			determined = true;
+			step = SolveStep(SolveStep::TYPE_FIXED, this);
 			return true;
 		}
 
@@ -53,28 +41,43 @@ namespace kinematics {
 		// then use it to determine the position of this joint.
 		for (int i = 0; i < links.size(); ++i) {
 			if (links[i]->isDetermined()) {
-				// calculate the position of this joint based on the joints whose position has already been determined.
-				pos = links[i]->transformByDeterminedJoints(id);
-				determined = true;
+				// use the first two joints of the link whose position has already been determined.
+				step = SolveStep(SolveStep::TYPE_RIGID, this);
+				step.link = links[i].get();
+				step.index = links[i]->indexOf(id);
+				for (int j = 0; j < links[i]->joints.size(); ++j) {
+					if (!links[i]->joints[j]->determined) continue;
+
+					if (step.index1 < 0) {
+						step.index1 = j;
+					}
+					else {
+						step.index2 = j;
+						break;
+					}
+				}
 				return true;
 			}
 		}
 
 		// If two of the links have at least one joint with its position determined,
 		// then use them to determine the position of this joint.
-		std::vector<glm::dvec2> positions;
-		std::vector<double> lengths;
+		std::vector<Joint*> positions;
+		std::vector<LengthRef> lengths;
 		for (int i = 0; i < links.size(); ++i) {
 			for (int j = 0; j < links[i]->joints.size(); ++j) {
 				if (links[i]->joints[j]->determined) {
-					positions.push_back(links[i]->joints[j]->pos);
-					lengths.push_back(links[i]->getLength(links[i]->joints[j]->id, id));
+					positions.push_back(links[i]->joints[j].get());
+					lengths.push_back(LengthRef(links[i].get(), j, links[i]->indexOf(id)));
 				}
 			}
 		}
 		if (positions.size() == 2) {
-			pos = circleCircleIntersection(positions[0], lengths[0], positions[1], lengths[1], pos);
-			determined = true;
+			step = SolveStep(SolveStep::TYPE_DYAD, this);
+			for (int i = 0; i < 2; ++i) {
+				step.joints[i] = positions[i];
+				step.lengths[i] = lengths[i];
+			}
 			return true;
 		}
 		else if (positions.size() == 0) {
@@ -89,15 +92,15 @@ namespace kinematics {
 
 			int link1;
 			int link2;
-			std::vector<double> lengths2;
+			std::vector<LengthRef> lengths2;
 			std::vector<int> pts_indices;
-			std::vector<glm::dvec2> prev_positions;
+			std::vector<Joint*> prev_positions;
 
 			for (int i = 0; i < links.size(); ++i) {
 				for (int j = 0; j < links[i]->joints.size(); ++j) {
 					if (links[i]->joints[j]->determined) {
-						positions.push_back(links[i]->joints[j]->pos);
-						lengths.push_back(links[i]->getLength(links[i]->joints[j]->id, id));
+						positions.push_back(links[i]->joints[j].get());
+						lengths.push_back(LengthRef(links[i].get(), j, links[i]->indexOf(id)));
 						link1 = i;
 						i = links.size();
 						break;
@@ -108,7 +111,12 @@ namespace kinematics {
 			for (int i = 0; i < links.size(); ++i) {
 				if (i == link1) continue;
 
+				// discard the joints found for the previous candidate link
+				positions.resize(1);
+				lengths.resize(1);
 				lengths2.clear();
+				pts_indices.clear();
+				prev_positions.clear();
 
 				// find two determined joints that are ajacent to link, links[i].
 				for (int j = 0; j < links[i]->joints.size(); j++) {
@@ -122,11 +130,11 @@ namespace kinematics {
 							if (links[i]->joints[j]->links[k]->joints[l]->id == links[i]->joints[j]->id) continue;
 
 							if (links[i]->joints[j]->links[k]->joints[l]->determined) {
-								positions.push_back(links[i]->joints[j]->links[k]->joints[l]->pos);
-								lengths.push_back(links[i]->joints[j]->links[k]->getLength(links[i]->joints[j]->id, links[i]->joints[j]->links[k]->joints[l]->id));
-								lengths2.push_back(links[i]->getLength(links[i]->joints[j]->id, id));
-								pts_indices.push_back(links[i]->joints[j]->id);
-								prev_positions.push_back(links[i]->joints[j]->pos);
+								positions.push_back(links[i]->joints[j]->links[k]->joints[l].get());
+								lengths.push_back(LengthRef(links[i]->joints[j]->links[k].get(), links[i]->joints[j]->links[k]->indexOf(links[i]->joints[j]->id), l));
+								lengths2.push_back(LengthRef(links[i].get(), j, links[i]->indexOf(id)));
+								pts_indices.push_back(j);
+								prev_positions.push_back(links[i]->joints[j].get());
 
 								// to exit the loop
 								k = links[i]->joints[j]->links.size();
@@ -143,10 +151,16 @@ namespace kinematics {
 			}
 
 			if (lengths2.size() == 2) {
-				lengths2.push_back(glm::length(links[link2]->original_shape[pts_indices[0]] - links[link2]->original_shape[pts_indices[1]]));
+				lengths2.push_back(LengthRef(links[link2].get(), pts_indices[0], pts_indices[1]));
 
-				pos = kinematics::threeLengths(positions[0], lengths[0], positions[1], lengths[1], positions[2], lengths[2], lengths2[0], lengths2[1], lengths2[2], pos, prev_positions[0], prev_positions[1]);
-				determined = true;
+				step = SolveStep(SolveStep::TYPE_TRIAD, this);
+				for (int i = 0; i < 3; ++i) {
+					step.joints[i] = positions[i];
+					step.lengths[i] = lengths[i];
+					step.lengths[i + 3] = lengths2[i];
+				}
+				step.joints[3] = prev_positions[0];
+				step.joints[4] = prev_positions[1];
 				return true;
 			}
 
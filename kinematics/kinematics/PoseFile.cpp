@@ -0,0 +1,111 @@
+#include "PoseFile.h"
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cctype>
+#include <cmath>
+
+namespace kinematics {
+
+	/**
+	 * Return the pose whose moving frame has the origin at p0 and the x axis toward p1.
+	 */
+	glm::dmat4x4 poseFromPoints(const glm::dvec2& p0, const glm::dvec2& p1) {
+		double theta = atan2(p1.y - p0.y, p1.x - p0.x);
+		return { cos(theta), sin(theta), 0, 0, -sin(theta), cos(theta), 0, 0, 0, 0, 1, 0, p0.x, p0.y, 0, 1 };
+	}
+
+	/**
+	 * Return the value of the attribute in the text of the tag, or the empty string if the tag does not have it.
+	 */
+	static std::string attribute(const std::string& tag, const std::string& name) {
+		for (size_t pos = tag.find(name); pos != std::string::npos; pos = tag.find(name, pos + 1)) {
+			// the name has to be a whole word followed by '='
+			if (pos == 0 || !isspace((unsigned char)tag[pos - 1])) continue;
+			size_t i = pos + name.size();
+			while (i < tag.size() && isspace((unsigned char)tag[i])) i++;
+			if (i >= tag.size() || tag[i] != '=') continue;
+			i++;
+			while (i < tag.size() && isspace((unsigned char)tag[i])) i++;
+			if (i >= tag.size() || (tag[i] != '"' && tag[i] != '\'')) continue;
+
+			size_t end = tag.find(tag[i], i + 1);
+			if (end == std::string::npos) return "";
+			return tag.substr(i + 1, end - i - 1);
+		}
+
+		return "";
+	}
+
+	/**
+	 * Read the precision poses from the XML file, in which each pose is specified by two points on the coupler,
+	 * i.e., the origin of the moving frame and a point on its x axis.
+	 * Only the subset of XML that the pose files use is supported, i.e., the elements, their attributes,
+	 * comments, and the declaration, so that the file can be read without any XML library.
+	 * An exception is thrown if the file cannot be read or does not have four poses.
+	 */
+	void readPoseFile(const std::string& filename, std::vector<glm::dmat4x4>& poses) {
+		std::ifstream in(filename);
+		if (!in) throw "File cannot open.";
+		std::stringstream buffer;
+		buffer << in.rdbuf();
+		std::string text = buffer.str();
+
+		poses.clear();
+
+		// names of the open elements from the root
+		std::vector<std::string> elements;
+		std::vector<glm::dvec2> pts;
+		bool has_root = false;
+
+		size_t pos = 0;
+		while ((pos = text.find('<', pos)) != std::string::npos) {
+			// skip the comments, the declaration, and the document type
+			if (text.compare(pos, 4, "<!--") == 0) {
+				pos = text.find("-->", pos);
+				if (pos == std::string::npos) throw "Invalid file format.";
+				pos += 3;
+				continue;
+			}
+			size_t end = text.find('>', pos);
+			if (end == std::string::npos) throw "Invalid file format.";
+			std::string tag = text.substr(pos + 1, end - pos - 1);
+			pos = end + 1;
+			if (tag.empty() || tag[0] == '?' || tag[0] == '!') continue;
+
+			if (tag[0] == '/') {
+				if (elements.empty()) throw "Invalid file format.";
+				if (elements.size() == 2 && elements.back() == "pose" && pts.size() == 2) {
+					poses.push_back(poseFromPoints(pts[0], pts[1]));
+				}
+				elements.pop_back();
+				continue;
+			}
+
+			bool empty_element = tag.back() == '/';
+			std::string name = tag.substr(0, tag.find_first_of(" \t\r\n/"));
+
+			if (elements.empty()) {
+				if (has_root || name != "poses") throw "Invalid file format.";
+				has_root = true;
+			}
+			else if (elements.size() == 1 && name == "pose") {
+				pts.clear();
+			}
+			else if (elements.size() == 2 && elements.back() == "pose" && name == "point") {
+				double x = strtod(attribute(tag, "x").c_str(), NULL);
+				double y = strtod(attribute(tag, "y").c_str(), NULL);
+				pts.push_back(glm::dvec2(x, y));
+			}
+
+			if (!empty_element) elements.push_back(name);
+		}
+
+		if (!has_root) throw "Invalid file format.";
+
+		if (poses.size() != 4) {
+			throw "Invalid number of poses was specified.";
+		}
+	}
+
+}
\ No newline at end of file
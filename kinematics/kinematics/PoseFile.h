@@ -0,0 +1,12 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <glm/glm.hpp>
+
+namespace kinematics {
+
+	glm::dmat4x4 poseFromPoints(const glm::dvec2& p0, const glm::dvec2& p1);
+	void readPoseFile(const std::string& filename, std::vector<glm::dmat4x4>& poses);
+
+}
\ No newline at end of file
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <vector>
+#include <utility>
+#include <cmath>
+#include <glm/glm.hpp>
+#include "KinematicUtils.h"
+
+namespace kinematics {
+
+	/**
+	 * The signs of the angles between N poses for finding the extreme poses, packed into N * (N - 1) bits.
+	 * The entry (j, k) for j != k is the bit j * (N - 1) + (k < j ? k : k - 1), i.e., each row of the table is
+	 * a run of N - 1 bits, and the diagonal is not stored. For four poses, the whole table is a 12-bit key.
+	 */
+	template<int N>
+	class PoseSignTable {
+	public:
+		std::bitset<N * (N - 1)> bits;
+
+	public:
+		PoseSignTable() {}
+		PoseSignTable(unsigned long key) : bits(key) {}
+
+		static int bit(int j, int k) { return j * (N - 1) + (k < j ? k : k - 1); }
+		bool get(int j, int k) const { return bits[bit(j, k)]; }
+		void set(int j, int k, bool value) { bits[bit(j, k)] = value; }
+		void swap(int j, int k);
+		unsigned long key() const { return bits.to_ulong(); }
+		std::pair<int, int> findExtremePoses() const;
+	};
+
+	/**
+	 * Swap the entries (j, k) and (k, j), which is needed only when they differ.
+	 */
+	template<int N>
+	void PoseSignTable<N>::swap(int j, int k) {
+		if (bits[bit(j, k)] != bits[bit(k, j)]) {
+			bits.flip(bit(j, k));
+			bits.flip(bit(k, j));
+		}
+	}
+
+	/**
+	 * Return the first pose j whose row is all true and the first pose j whose column is all true, or -1 if there is no such pose.
+	 */
+	template<int N>
+	std::pair<int, int> PoseSignTable<N>::findExtremePoses() const {
+		int pose1 = -1;
+		int pose2 = -1;
+		for (int j = 0; j < N && pose1 < 0; j++) {
+			bool extreme = true;
+			for (int k = 0; k < N && extreme; k++) {
+				if (k != j && !get(j, k)) extreme = false;
+			}
+			if (extreme) pose1 = j;
+		}
+		for (int j = 0; j < N && pose2 < 0; j++) {
+			bool extreme = true;
+			for (int k = 0; k < N && extreme; k++) {
+				if (k != j && !get(k, j)) extreme = false;
+			}
+			if (extreme) pose2 = j;
+		}
+
+		return std::make_pair(pose1, pose2);
+	}
+
+	/**
+	 * A fixed number of precision poses and the tables derived from them, i.e., the angle theta_i of each pose,
+	 * two points on the coupler in each pose, the poles P_{ij} (P[0]), and the image poles P_{ij}' with respect to
+	 * the first pose (P[1]). The tables are std::array of the compile-time size N, so that setting up a pose set
+	 * does not allocate any memory on the heap, and the loops over the poses have constant trip counts.
+	 * When one pose is changed by setPose, only the entries that depend on it are recalculated.
+	 */
+	template<int N>
+	class PoseSet {
+	public:
+		typedef std::array<std::array<glm::dvec2, N>, N> PoleMatrix;
+		typedef std::array<PoleMatrix, 2> PoleTable;
+		typedef PoseSignTable<N> SignTable;
+
+		std::array<glm::dmat4x4, N> poses;
+		std::array<double, N> theta;
+		std::array<std::array<glm::dvec2, 2>, N> points;
+		PoleTable P;
+
+	public:
+		PoseSet() {}
+		PoseSet(const std::vector<glm::dmat4x4>& poses);
+
+		void update();
+		void setPose(int i, const glm::dmat4x4& pose);
+
+	private:
+		void updatePose(int i);
+		void updatePole(int i, int j);
+		void updateImagePoles();
+	};
+
+	template<int N>
+	PoseSet<N>::PoseSet(const std::vector<glm::dmat4x4>& poses) {
+		if (poses.size() != N) throw "Invalid number of poses was specified.";
+
+		for (int i = 0; i < N; i++) {
+			this->poses[i] = poses[i];
+		}
+		update();
+	}
+
+	/**
+	 * Calculate the angles, the poles, and the image poles from the poses.
+	 */
+	template<int N>
+	void PoseSet<N>::update() {
+		for (int i = 0; i < N; i++) {
+			updatePose(i);
+			P[0][i][i] = glm::dvec2(0, 0);
+		}
+		for (int i = 0; i < N - 1; i++) {
+			for (int j = i + 1; j < N; j++) {
+				updatePole(i, j);
+			}
+		}
+		updateImagePoles();
+	}
+
+	/**
+	 * Change the i-th pose, and recalculate its angle, the poles P_{ij}, and the image poles.
+	 * The poles between the other poses are kept as they are.
+	 */
+	template<int N>
+	void PoseSet<N>::setPose(int i, const glm::dmat4x4& pose) {
+		poses[i] = pose;
+		updatePose(i);
+		for (int j = 0; j < N; j++) {
+			if (j < i) updatePole(j, i);
+			else if (j > i) updatePole(i, j);
+		}
+		updateImagePoles();
+	}
+
+	/**
+	 * Calculate theta_i and the coordinates of two points on the coupler in the i-th pose.
+	 */
+	template<int N>
+	void PoseSet<N>::updatePose(int i) {
+		theta[i] = M_PI;
+		if (poses[i][0][0] != 0.0) {
+			theta[i] = atan2(poses[i][0][1], poses[i][0][0]);
+		}
+
+		points[i][0] = glm::dvec2(poses[i] * glm::dvec4(0, 0, 0, 1));
+		points[i][1] = glm::dvec2(poses[i] * glm::dvec4(0.843, 0, 0, 1));
+	}
+
+	/**
+	 * Calculate the coordinates of pole_{i,j} for i < j.
+	 */
+	template<int N>
+	void PoseSet<N>::updatePole(int i, int j) {
+		glm::dvec2 m1 = (points[i][0] + points[j][0]) * 0.5;
+		glm::dvec2 v1 = points[j][0] - points[i][0];
+		glm::dvec2 n1(-v1.y, v1.x);
+		n1 /= glm::length(n1);
+
+		glm::dvec2 m2 = (points[i][1] + points[j][1]) * 0.5;
+		glm::dvec2 v2 = points[j][1] - points[i][1];
+		glm::dvec2 n2(-v2.y, v2.x);
+		n2 /= glm::length(n2);
+
+		glm::dvec2 pole(0, 0);
+		kinematics::lineLineIntersection(m1, n1, m2, n2, pole);
+		P[0][i][j] = pole;
+		P[0][j][i] = pole;
+	}
+
+	/**
+	 * Calculate the image poles, P_{jk}' for 1 < j < k. The others are the same as the poles.
+	 */
+	template<int N>
+	void PoseSet<N>::updateImagePoles() {
+		P[1] = P[0];
+		for (int j = 1; j < N - 1; j++) {
+			for (int k = j + 1; k < N; k++) {
+				P[1][j][k] = kinematics::reflect(P[0][j][k], P[0][0][j], P[0][0][j] - P[0][0][k]);
+				P[1][k][j] = P[1][j][k];
+			}
+		}
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define KINEMATICS_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define KINEMATICS_SSE2
+#endif
+
+namespace kinematics {
+
+	/**
+	 * A mask of one lane for the scalar fallback of the batched kernels.
+	 */
+	class ScalarMask {
+	public:
+		bool m;
+
+	public:
+		ScalarMask(bool m) : m(m) {}
+
+		friend ScalarMask operator&(const ScalarMask& a, const ScalarMask& b) { return ScalarMask(a.m && b.m); }
+		friend ScalarMask operator|(const ScalarMask& a, const ScalarMask& b) { return ScalarMask(a.m || b.m); }
+		friend ScalarMask operator!(const ScalarMask& a) { return ScalarMask(!a.m); }
+		void store(unsigned char* p) const { p[0] = m ? 1 : 0; }
+	};
+
+	/**
+	 * One double for the scalar fallback of the batched kernels.
+	 * The kernels are written with these operators so that the same code runs on the SIMD lanes below.
+	 * Each operation is a single IEEE operation, so the SIMD lanes give exactly the same results as this one.
+	 */
+	class ScalarLane {
+	public:
+		typedef ScalarMask Mask;
+		static const int width = 1;
+		double v;
+
+	public:
+		ScalarLane() : v(0) {}
+		ScalarLane(double v) : v(v) {}
+
+		static ScalarLane load(const double* p) { return ScalarLane(p[0]); }
+		void store(double* p) const { p[0] = v; }
+
+		friend ScalarLane operator+(const ScalarLane& a, const ScalarLane& b) { return ScalarLane(a.v + b.v); }
+		friend ScalarLane operator-(const ScalarLane& a, const ScalarLane& b) { return ScalarLane(a.v - b.v); }
+		friend ScalarLane operator*(const ScalarLane& a, const ScalarLane& b) { return ScalarLane(a.v * b.v); }
+		friend ScalarLane operator/(const ScalarLane& a, const ScalarLane& b) { return ScalarLane(a.v / b.v); }
+		friend ScalarLane operator-(const ScalarLane& a) { return ScalarLane(-a.v); }
+		friend ScalarMask operator<(const ScalarLane& a, const ScalarLane& b) { return ScalarMask(a.v < b.v); }
+		friend ScalarMask operator<=(const ScalarLane& a, const ScalarLane& b) { return ScalarMask(a.v <= b.v); }
+		friend ScalarMask operator>(const ScalarLane& a, const ScalarLane& b) { return ScalarMask(a.v > b.v); }
+		friend ScalarMask operator>=(const ScalarLane& a, const ScalarLane& b) { return ScalarMask(a.v >= b.v); }
+		friend ScalarMask operator!=(const ScalarLane& a, const ScalarLane& b) { return ScalarMask(a.v != b.v); }
+		friend ScalarLane sqrt(const ScalarLane& a) { return ScalarLane(std::sqrt(a.v)); }
+		friend ScalarLane abs(const ScalarLane& a) { return ScalarLane(std::abs(a.v)); }
+
+		/** Same as std::max(a, b). */
+		friend ScalarLane max(const ScalarLane& a, const ScalarLane& b) { return (a.v < b.v) ? b : a; }
+
+		/** Return a where the mask is set, and b elsewhere. */
+		friend ScalarLane select(const ScalarMask& mask, const ScalarLane& a, const ScalarLane& b) { return mask.m ? a : b; }
+	};
+
+#if defined(KINEMATICS_AVX)
+	class DoubleMask {
+	public:
+		__m256d m;
+
+	public:
+		DoubleMask(__m256d m) : m(m) {}
+
+		friend DoubleMask operator&(const DoubleMask& a, const DoubleMask& b) { return DoubleMask(_mm256_and_pd(a.m, b.m)); }
+		friend DoubleMask operator|(const DoubleMask& a, const DoubleMask& b) { return DoubleMask(_mm256_or_pd(a.m, b.m)); }
+		friend DoubleMask operator!(const DoubleMask& a) { return DoubleMask(_mm256_xor_pd(a.m, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)))); }
+		void store(unsigned char* p) const {
+			int bits = _mm256_movemask_pd(m);
+			for (int i = 0; i < 4; i++) p[i] = (bits >> i) & 1;
+		}
+	};
+
+	/**
+	 * Four doubles in an AVX register.
+	 */
+	class DoubleLane {
+	public:
+		typedef DoubleMask Mask;
+		static const int width = 4;
+		__m256d v;
+
+	public:
+		DoubleLane() : v(_mm256_setzero_pd()) {}
+		DoubleLane(double v) : v(_mm256_set1_pd(v)) {}
+		DoubleLane(__m256d v) : v(v) {}
+
+		static DoubleLane load(const double* p) { return DoubleLane(_mm256_loadu_pd(p)); }
+		void store(double* p) const { _mm256_storeu_pd(p, v); }
+
+		friend DoubleLane operator+(const DoubleLane& a, const DoubleLane& b) { return DoubleLane(_mm256_add_pd(a.v, b.v)); }
+		friend DoubleLane operator-(const DoubleLane& a, const DoubleLane& b) { return DoubleLane(_mm256_sub_pd(a.v, b.v)); }
+		friend DoubleLane operator*(const DoubleLane& a, const DoubleLane& b) { return DoubleLane(_mm256_mul_pd(a.v, b.v)); }
+		friend DoubleLane operator/(const DoubleLane& a, const DoubleLane& b) { return DoubleLane(_mm256_div_pd(a.v, b.v)); }
+		friend DoubleLane operator-(const DoubleLane& a) { return DoubleLane(_mm256_xor_pd(a.v, _mm256_set1_pd(-0.0))); }
+		friend DoubleMask operator<(const DoubleLane& a, const DoubleLane& b) { return DoubleMask(_mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ)); }
+		friend DoubleMask operator<=(const DoubleLane& a, const DoubleLane& b) { return DoubleMask(_mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ)); }
+		friend DoubleMask operator>(const DoubleLane& a, const DoubleLane& b) { return DoubleMask(_mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ)); }
+		friend DoubleMask operator>=(const DoubleLane& a, const DoubleLane& b) { return DoubleMask(_mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ)); }
+		friend DoubleMask operator!=(const DoubleLane& a, const DoubleLane& b) { return DoubleMask(_mm256_cmp_pd(a.v, b.v, _CMP_NEQ_UQ)); }
+		friend DoubleLane sqrt(const DoubleLane& a) { return DoubleLane(_mm256_sqrt_pd(a.v)); }
+		friend DoubleLane abs(const DoubleLane& a) { return DoubleLane(_mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v)); }
+		friend DoubleLane max(const DoubleLane& a, const DoubleLane& b) { return DoubleLane(_mm256_max_pd(b.v, a.v)); }
+		friend DoubleLane select(const DoubleMask& mask, const DoubleLane& a, const DoubleLane& b) { return DoubleLane(_mm256_blendv_pd(b.v, a.v, mask.m)); }
+	};
+#elif defined(KINEMATICS_SSE2)
+	class DoubleMask {
+	public:
+		__m128d m;
+
+	public:
+		DoubleMask(__m128d m) : m(m) {}
+
+		friend DoubleMask operator&(const DoubleMask& a, const DoubleMask& b) { return DoubleMask(_mm_and_pd(a.m, b.m)); }
+		friend DoubleMask operator|(const DoubleMask& a, const DoubleMask& b) { return DoubleMask(_mm_or_pd(a.m, b.m)); }
+		friend DoubleMask operator!(const DoubleMask& a) { return DoubleMask(_mm_xor_pd(a.m, _mm_castsi128_pd(_mm_set1_epi32(-1)))); }
+		void store(unsigned char* p) const {
+			int bits = _mm_movemask_pd(m);
+			for (int i = 0; i < 2; i++) p[i] = (bits >> i) & 1;
+		}
+	};
+
+	/**
+	 * Two doubles in an SSE2 register.
+	 */
+	class DoubleLane {
+	public:
+		typedef DoubleMask Mask;
+		static const int width = 2;
+		__m128d v;
+
+	public:
+		DoubleLane() : v(_mm_setzero_pd()) {}
+		DoubleLane(double v) : v(_mm_set1_pd(v)) {}
+		DoubleLane(__m128d v) : v(v) {}
+
+		static DoubleLane load(const double* p) { return DoubleLane(_mm_loadu_pd(p)); }
+		void store(double* p) const { _mm_storeu_pd(p, v); }
+
+		friend DoubleLane operator+(const DoubleLane& a, const DoubleLane& b) { return DoubleLane(_mm_add_pd(a.v, b.v)); }
+		friend DoubleLane operator-(const DoubleLane& a, const DoubleLane& b) { return DoubleLane(_mm_sub_pd(a.v, b.v)); }
+		friend DoubleLane operator*(const DoubleLane& a, const DoubleLane& b) { return DoubleLane(_mm_mul_pd(a.v, b.v)); }
+		friend DoubleLane operator/(const DoubleLane& a, const DoubleLane& b) { return DoubleLane(_mm_div_pd(a.v, b.v)); }
+		friend DoubleLane operator-(const DoubleLane& a) { return DoubleLane(_mm_xor_pd(a.v, _mm_set1_pd(-0.0))); }
+		friend DoubleMask operator<(const DoubleLane& a, const DoubleLane& b) { return DoubleMask(_mm_cmplt_pd(a.v, b.v)); }
+		friend DoubleMask operator<=(const DoubleLane& a, const DoubleLane& b) { return DoubleMask(_mm_cmple_pd(a.v, b.v)); }
+		friend DoubleMask operator>(const DoubleLane& a, const DoubleLane& b) { return DoubleMask(_mm_cmpgt_pd(a.v, b.v)); }
+		friend DoubleMask operator>=(const DoubleLane& a, const DoubleLane& b) { return DoubleMask(_mm_cmpge_pd(a.v, b.v)); }
+		friend DoubleMask operator!=(const DoubleLane& a, const DoubleLane& b) { return DoubleMask(_mm_cmpneq_pd(a.v, b.v)); }
+		friend DoubleLane sqrt(const DoubleLane& a) { return DoubleLane(_mm_sqrt_pd(a.v)); }
+		friend DoubleLane abs(const DoubleLane& a) { return DoubleLane(_mm_andnot_pd(_mm_set1_pd(-0.0), a.v)); }
+		friend DoubleLane max(const DoubleLane& a, const DoubleLane& b) { return DoubleLane(_mm_max_pd(b.v, a.v)); }
+		friend DoubleLane select(const DoubleMask& mask, const DoubleLane& a, const DoubleLane& b) { return DoubleLane(_mm_or_pd(_mm_and_pd(mask.m, a.v), _mm_andnot_pd(mask.m, b.v))); }
+	};
+#else
+	typedef ScalarMask DoubleMask;
+	typedef ScalarLane DoubleLane;
+#endif
+
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "SliderHinge.h"
 #include "Link.h"
 #include "KinematicUtils.h"
+#include "SolveSchedule.h"
 
 namespace kinematics {
 
@@ -11,66 +12,40 @@ namespace kinematics {
 		this->pos = pos;
 	}
 
-	SliderHinge::SliderHinge(QDomElement& node) : Joint() {
-		id = node.attribute("id").toInt();
-		type = TYPE_SLIDER_HINGE;
-		this->ground = node.attribute("ground").toLower() == "true";
-		pos.x = node.attribute("x").toDouble();
-		pos.y = node.attribute("y").toDouble();
-	}
-
-	void SliderHinge::draw(QPainter& painter, const QPointF& origin, float scale) {
-		painter.save();
-		painter.setPen(QPen(QColor(0, 0, 0), 1));
-		painter.setBrush(QBrush(QColor(255, 255, 255)));
-
-		double theta = 0.0;
-		if (links.size() > 0) {
-			for (int i = 0; i < links[0]->joints.size(); ++i) {
-				if (links[0]->joints[i]->id != id && links[0]->joints[i]->ground) {
-					theta = atan2(links[0]->joints[i]->pos.y - pos.y, links[0]->joints[i]->pos.x - pos.x);
-				}
-			}
-		}
-
-		painter.translate(origin.x() + pos.x * scale, origin.y() - pos.y * scale);
-		painter.rotate(-theta / M_PI * 180);
-		painter.drawRect(-20, -5, 40, 10);
-
-		painter.drawEllipse(QPoint(0, 0), 5, 5);
-		painter.restore();
-	}
 
 	void SliderHinge::stepForward(double step_size) {
 	}
 
 	/**
-	* Update the position of this joint.
-	* Return true if the position is updated.
+	* Choose the primitive that determines the position of this joint, and store it in the step.
+	* Return true if the position can be determined.
 	* Return false if one of the positions of the parent nodes has not been updated yet.
 	*/
-	bool SliderHinge::forwardKinematics() {
+	bool SliderHinge::plan(SolveStep& step) {
 		if (links.size() == 0) {
-			determined = true;
+			step = SolveStep(SolveStep::TYPE_FIXED, this);
 			return true;
 		}
 
 		// If two of the links have at least one joint with its position determined,
 		// then use them to determine the position of this joint.
-		std::vector<glm::dvec2> positions;
-		std::vector<double> lengths;
+		std::vector<Joint*> positions;
+		std::vector<LengthRef> lengths;
 		for (int i = 0; i < links.size(); ++i) {
 			for (int j = 0; j < links[i]->joints.size(); ++j) {
 				if (links[i]->joints[j]->determined) {
-					positions.push_back(links[i]->joints[j]->pos);
-					lengths.push_back(links[i]->getLength(links[i]->joints[j]->id, id));
+					positions.push_back(links[i]->joints[j].get());
+					lengths.push_back(LengthRef(links[i].get(), j, links[i]->indexOf(id)));
 					break;
 				}
 			}
 		}
 		if (positions.size() == 2) {
-			pos = circleLineIntersection(positions[1], lengths[1], positions[0], pos, pos);
-			determined = true;
+			step = SolveStep(SolveStep::TYPE_SLIDER_DYAD, this);
+			for (int i = 0; i < 2; ++i) {
+				step.joints[i] = positions[i];
+				step.lengths[i] = lengths[i];
+			}
 			return true;
 		}
 		else if (positions.size() < 2) {
@@ -83,7 +58,6 @@ namespace kinematics {
 		// Otherwise, postpone updating the position later.
 		return false;
 
-
 		/*
 		if (in_links.size() == 0) return true;
 
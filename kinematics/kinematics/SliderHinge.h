@@ -1,7 +1,6 @@
 #pragma once
 
 #include "Joint.h"
-#include <QDomDocument>
 
 namespace kinematics {
 
@@ -11,11 +10,9 @@ namespace kinematics {
 
 	public:
 		SliderHinge(int id, bool ground, const glm::dvec2& pos);
-		SliderHinge(QDomElement& node);
 
-		void draw(QPainter& painter, const QPointF& origin, float scale);
 		void stepForward(double step_size);
-		bool forwardKinematics();
+		bool plan(SolveStep& step);
 	};
 
 }
\ No newline at end of file
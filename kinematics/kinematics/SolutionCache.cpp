@@ -0,0 +1,376 @@
+#include "SolutionCache.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <cstdio>
+
+namespace kinematics {
+
+	template<typename T>
+	static void writeValue(std::ostream& out, const T& value) {
+		out.write((const char*)&value, sizeof(T));
+	}
+
+	template<typename T>
+	static bool readValue(std::istream& in, T& value) {
+		in.read((char*)&value, sizeof(T));
+		return (bool)in;
+	}
+
+	template<typename T>
+	static void writeArray(std::ostream& out, const std::vector<T>& values) {
+		writeValue(out, (int)values.size());
+		if (values.size() > 0) out.write((const char*)values.data(), sizeof(T) * values.size());
+	}
+
+	/**
+	 * Return the number of bytes left in the stream, or -1 if it is unknown.
+	 */
+	static long long remainingBytes(std::istream& in) {
+		std::streampos pos = in.tellg();
+		if (pos < 0) return -1;
+		in.seekg(0, std::ios::end);
+		std::streampos end = in.tellg();
+		in.seekg(pos);
+		return end < 0 ? -1 : (long long)(end - pos);
+	}
+
+	/**
+	 * Read the number of the elements, each of which takes at least element_size bytes in the stream.
+	 * The number is rejected if the rest of the stream cannot hold that many elements, so that a broken file
+	 * does not make the reader allocate a huge amount of memory.
+	 */
+	static bool readSize(std::istream& in, int& size, long long element_size) {
+		if (!readValue(in, size) || size < 0) return false;
+		long long remaining = remainingBytes(in);
+		return remaining >= 0 && size * element_size <= remaining;
+	}
+
+	template<typename T>
+	static bool readArray(std::istream& in, std::vector<T>& values) {
+		int size;
+		if (!readSize(in, size, sizeof(T))) return false;
+		values.resize(size);
+		if (size > 0) in.read((char*)values.data(), sizeof(T) * size);
+		return (bool)in;
+	}
+
+	static void writeSpecialPoints(std::ostream& out, const std::vector<SpecialPoint>& points) {
+		writeValue(out, (int)points.size());
+		for (int i = 0; i < points.size(); i++) {
+			writeValue(out, points[i].index);
+			writeValue(out, points[i].type);
+			writeValue(out, points[i].subscript.first);
+			writeValue(out, points[i].subscript.second);
+		}
+	}
+
+	static bool readSpecialPoints(std::istream& in, std::vector<SpecialPoint>& points) {
+		int size;
+		if (!readSize(in, size, sizeof(int) * 4)) return false;
+		points.clear();
+		for (int i = 0; i < size; i++) {
+			int index, type, first, second;
+			if (!readValue(in, index) || !readValue(in, type) || !readValue(in, first) || !readValue(in, second)) return false;
+			points.push_back(SpecialPoint(index, type, { first, second }));
+		}
+		return true;
+	}
+
+	/**
+	 * Return the canonical byte string of the pose matrices and the parameters that affect the result.
+	 * The parameters that do not change the result, e.g., the number of threads, are not included.
+	 */
+	std::string SolutionCache::makeKey(const std::vector<glm::dmat4x4>& poses, const CurveSamplingParams& params, const SolutionSearchParams& search_params) {
+		std::ostringstream out(std::ios::binary);
+		writeValue(out, (int)VERSION);
+		writeValue(out, (int)poses.size());
+		for (int i = 0; i < poses.size(); i++) {
+			for (int j = 0; j < 4; j++) {
+				for (int k = 0; k < 4; k++) {
+					// -0.0 and 0.0 are the same pose
+					double value = poses[i][j][k] == 0.0 ? 0.0 : poses[i][j][k];
+					writeValue(out, value);
+				}
+			}
+		}
+
+		writeValue(out, params.tolerance);
+		writeValue(out, params.max_spacing);
+		writeValue(out, params.min_step);
+		writeValue(out, params.max_step);
+		writeValue(out, params.probe_step);
+		writeValue(out, params.max_radius);
+		writeValue(out, params.stitch_distance);
+
+		writeValue(out, search_params.max_solutions);
+		writeValue(out, (char)search_params.allow_defects);
+
+		return out.str();
+	}
+
+	/**
+	 * Return the 64-bit FNV-1a hash of the key as a hexadecimal string.
+	 */
+	std::string SolutionCache::hash(const std::string& key) {
+		unsigned long long h = 14695981039346656037ULL;
+		for (int i = 0; i < key.size(); i++) {
+			h ^= (unsigned char)key[i];
+			h *= 1099511628211ULL;
+		}
+
+		std::ostringstream out;
+		out << std::hex << std::setw(16) << std::setfill('0') << h;
+		return out.str();
+	}
+
+	/**
+	 * Set the directory of the on-disk cache. The empty string disables it.
+	 */
+	void SolutionCache::setDirectory(const std::string& directory) {
+		std::lock_guard<std::mutex> lock(mutex);
+		this->directory = directory;
+	}
+
+	/**
+	 * Find the entry of the key in the memory, and then in the directory.
+	 * If it is found, true is returned, and the entry becomes the most recently used one.
+	 */
+	bool SolutionCache::find(const std::string& key, SolutionCacheEntry& entry) {
+		std::string directory;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			auto it = lookup.find(key);
+			if (it != lookup.end()) {
+				entries.splice(entries.begin(), entries, it->second);
+				entry = it->second->second;
+				return true;
+			}
+
+			directory = this->directory;
+		}
+
+		if (directory.empty()) return false;
+
+		// the file is read without the lock, so that the other threads can use the memory cache meanwhile
+		SolutionCacheEntry ret;
+		std::ifstream in(filePath(directory, key), std::ios::binary);
+		if (!in || !read(in, key, ret)) return false;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		insertToMemory(key, ret);
+		entry = ret;
+		return true;
+	}
+
+	/**
+	 * Insert the entry of the key, or replace the existing one.
+	 * The least recently used entry is evicted from the memory if the cache is full.
+	 */
+	void SolutionCache::insert(const std::string& key, const SolutionCacheEntry& entry) {
+		std::string directory;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			insertToMemory(key, entry);
+			directory = this->directory;
+		}
+
+		if (directory.empty()) return;
+
+		// the file is written without the lock to a temporary file of this thread, and then renamed,
+		// so that a reader never sees a file half written by another thread
+		std::string path = filePath(directory, key);
+		std::ostringstream temp_path;
+		temp_path << path << "." << std::this_thread::get_id() << ".tmp";
+		{
+			std::ofstream out(temp_path.str(), std::ios::binary | std::ios::trunc);
+			if (!out) return;
+			write(out, key, entry);
+			if (!out) {
+				out.close();
+				std::remove(temp_path.str().c_str());
+				return;
+			}
+		}
+
+		// rename does not replace an existing file on Windows
+		if (std::rename(temp_path.str().c_str(), path.c_str()) != 0) {
+			std::remove(path.c_str());
+			if (std::rename(temp_path.str().c_str(), path.c_str()) != 0) std::remove(temp_path.str().c_str());
+		}
+	}
+
+	/**
+	 * Remove all the entries from the memory. The files in the directory are kept.
+	 */
+	void SolutionCache::clear() {
+		std::lock_guard<std::mutex> lock(mutex);
+		entries.clear();
+		lookup.clear();
+	}
+
+	void SolutionCache::insertToMemory(const std::string& key, const SolutionCacheEntry& entry) {
+		auto it = lookup.find(key);
+		if (it != lookup.end()) {
+			entries.erase(it->second);
+			lookup.erase(it);
+		}
+
+		entries.push_front(std::make_pair(key, entry));
+		lookup[key] = entries.begin();
+
+		while (entries.size() > capacity) {
+			lookup.erase(entries.back().first);
+			entries.pop_back();
+		}
+	}
+
+	std::string SolutionCache::filePath(const std::string& directory, const std::string& key) {
+		return directory + "/" + hash(key) + ".bsc";
+	}
+
+	/**
+	 * Write the entry with the key, so that the reader can verify that the file is for the key.
+	 */
+	void SolutionCache::write(std::ostream& out, const std::string& key, const SolutionCacheEntry& entry) {
+		out.write("BSC", 3);
+		writeValue(out, (int)VERSION);
+		writeValue(out, (int)key.size());
+		out.write(key.data(), key.size());
+
+		writeValue(out, (int)entry.solutions.size());
+		for (int i = 0; i < entry.solutions.size(); i++) {
+			const CurveSet& curves = entry.solutions[i];
+			writeArray(out, curves.x);
+			writeArray(out, curves.y);
+			writeArray(out, curves.offsets);
+			std::vector<char> closed(curves.closed.begin(), curves.closed.end());
+			writeArray(out, closed);
+		}
+
+		writeValue(out, (int)entry.pole_intersections.size());
+		for (int i = 0; i < entry.pole_intersections.size(); i++) {
+			writeValue(out, (int)entry.pole_intersections[i].size());
+			for (int j = 0; j < entry.pole_intersections[i].size(); j++) {
+				writeSpecialPoints(out, entry.pole_intersections[i][j]);
+			}
+		}
+
+		writeValue(out, (int)entry.UTs.size());
+		for (int i = 0; i < entry.UTs.size(); i++) {
+			writeSpecialPoints(out, entry.UTs[i]);
+		}
+
+		writeValue(out, (int)entry.extreme_poses.size());
+		for (int i = 0; i < entry.extreme_poses.size(); i++) {
+			writeValue(out, (int)entry.extreme_poses[i].size());
+			for (int j = 0; j < entry.extreme_poses[i].size(); j++) {
+				writeValue(out, std::get<0>(entry.extreme_poses[i][j]));
+				writeValue(out, std::get<1>(entry.extreme_poses[i][j]));
+				writeValue(out, std::get<2>(entry.extreme_poses[i][j]));
+			}
+		}
+
+		writeValue(out, (char)entry.solved);
+		writeValue(out, (int)entry.candidates.size());
+		for (int i = 0; i < entry.candidates.size(); i++) {
+			const SolutionCandidate& candidate = entry.candidates[i];
+			writeValue(out, candidate.length);
+			writeValue(out, candidate.order);
+			writeValue(out, candidate.C1);
+			writeValue(out, candidate.C2);
+			writeValue(out, candidate.X1);
+			writeValue(out, candidate.X2);
+			writeValue(out, candidate.grashof_type);
+			writeValue(out, (char)candidate.grashof_defect);
+			writeValue(out, (char)candidate.order_defect);
+			writeValue(out, (char)candidate.branch_defect);
+		}
+	}
+
+	/**
+	 * Read the entry written by write(). If the file is broken or is not for the key, false is returned.
+	 */
+	bool SolutionCache::read(std::istream& in, const std::string& key, SolutionCacheEntry& entry) {
+		char magic[3];
+		int version;
+		int key_size;
+		in.read(magic, 3);
+		if (!in || magic[0] != 'B' || magic[1] != 'S' || magic[2] != 'C') return false;
+		if (!readValue(in, version) || version != VERSION) return false;
+		if (!readValue(in, key_size) || key_size != key.size()) return false;
+		std::string file_key(key_size, '\0');
+		in.read(&file_key[0], key_size);
+		if (!in || file_key != key) return false;
+
+		// the sizes are bounded by the rest of the file, whose every element takes at least the given number of bytes
+		SolutionCacheEntry ret;
+		int size;
+		if (!readSize(in, size, sizeof(int) * 4)) return false;
+		ret.solutions.resize(size);
+		for (int i = 0; i < size; i++) {
+			CurveSet& curves = ret.solutions[i];
+			std::vector<char> closed;
+			if (!readArray(in, curves.x) || !readArray(in, curves.y) || !readArray(in, curves.offsets) || !readArray(in, closed)) return false;
+			if (curves.x.size() != curves.y.size() || curves.offsets.size() != closed.size() + 1) return false;
+
+			// the offsets have to start at 0, increase monotonically, and end at the number of points
+			if (curves.offsets.front() != 0 || curves.offsets.back() != curves.x.size()) return false;
+			for (int j = 0; j + 1 < curves.offsets.size(); j++) {
+				if (curves.offsets[j] > curves.offsets[j + 1]) return false;
+			}
+			curves.closed.assign(closed.begin(), closed.end());
+		}
+
+		if (!readSize(in, size, sizeof(int))) return false;
+		ret.pole_intersections.resize(size);
+		for (int i = 0; i < size; i++) {
+			int num_loops;
+			if (!readSize(in, num_loops, sizeof(int))) return false;
+			ret.pole_intersections[i].resize(num_loops);
+			for (int j = 0; j < num_loops; j++) {
+				if (!readSpecialPoints(in, ret.pole_intersections[i][j])) return false;
+			}
+		}
+
+		if (!readSize(in, size, sizeof(int))) return false;
+		ret.UTs.resize(size);
+		for (int i = 0; i < size; i++) {
+			if (!readSpecialPoints(in, ret.UTs[i])) return false;
+		}
+
+		if (!readSize(in, size, sizeof(int))) return false;
+		ret.extreme_poses.resize(size);
+		for (int i = 0; i < size; i++) {
+			int num_points;
+			if (!readSize(in, num_points, sizeof(int) * 3)) return false;
+			for (int j = 0; j < num_points; j++) {
+				int index, pose1, pose2;
+				if (!readValue(in, index) || !readValue(in, pose1) || !readValue(in, pose2)) return false;
+				ret.extreme_poses[i].push_back(std::make_tuple(index, pose1, pose2));
+			}
+		}
+
+		char solved;
+		if (!readValue(in, solved)) return false;
+		ret.solved = solved != 0;
+		if (!readSize(in, size, sizeof(double) + sizeof(long long) + sizeof(glm::dvec2) * 4 + sizeof(int) + 3)) return false;
+		ret.candidates.resize(size);
+		for (int i = 0; i < size; i++) {
+			SolutionCandidate& candidate = ret.candidates[i];
+			char grashof_defect, order_defect, branch_defect;
+			if (!readValue(in, candidate.length) || !readValue(in, candidate.order)) return false;
+			if (!readValue(in, candidate.C1) || !readValue(in, candidate.C2) || !readValue(in, candidate.X1) || !readValue(in, candidate.X2)) return false;
+			if (!readValue(in, candidate.grashof_type) || !readValue(in, grashof_defect) || !readValue(in, order_defect) || !readValue(in, branch_defect)) return false;
+			candidate.grashof_defect = grashof_defect != 0;
+			candidate.order_defect = order_defect != 0;
+			candidate.branch_defect = branch_defect != 0;
+		}
+
+		entry = ret;
+		return true;
+	}
+
+}
\ No newline at end of file
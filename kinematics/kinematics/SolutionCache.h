@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <list>
+#include <tuple>
+#include <string>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "Burmester.h"
+#include "CurveSet.h"
+
+namespace kinematics {
+
+	/**
+	 * The products of solving a pose set, i.e., the solution curves, the special points, the extreme poses,
+	 * and the ranked solutions. solved is true if the solution search was completed, in which case candidates
+	 * are the best solutions (possibly none). The result of an interrupted search must not be stored as solved,
+	 * since the time limit of the search is not a part of the key.
+	 */
+	class SolutionCacheEntry {
+	public:
+		std::vector<CurveSet> solutions;
+		std::vector<std::vector<std::vector<SpecialPoint>>> pole_intersections;
+		std::vector<std::vector<SpecialPoint>> UTs;
+		std::vector<std::vector<std::tuple<int, int, int>>> extreme_poses;
+		bool solved;
+		std::vector<SolutionCandidate> candidates;
+
+	public:
+		SolutionCacheEntry() : solved(false) {}
+	};
+
+	/**
+	 * Content-addressed LRU cache of the solved pose sets.
+	 * The key is the canonical byte string of the pose matrices and the parameters that affect the result,
+	 * and the entries are also stored in the directory (if it is not empty) as files named by the hash of the key,
+	 * so that they survive across the runs. The cache can be used from multiple threads, and the files are read and
+	 * written outside the lock, so that a thread waiting for the disk does not block the lookups of the other threads.
+	 */
+	class SolutionCache {
+	public:
+		static const int VERSION = 1;
+
+	private:
+		int capacity;
+		std::string directory;
+		std::list<std::pair<std::string, SolutionCacheEntry>> entries;
+		std::unordered_map<std::string, std::list<std::pair<std::string, SolutionCacheEntry>>::iterator> lookup;
+		std::mutex mutex;
+
+	public:
+		SolutionCache(int capacity = 64, const std::string& directory = "") : capacity(capacity), directory(directory) {}
+
+		static std::string makeKey(const std::vector<glm::dmat4x4>& poses, const CurveSamplingParams& params, const SolutionSearchParams& search_params);
+		static std::string hash(const std::string& key);
+
+		void setDirectory(const std::string& directory);
+		bool find(const std::string& key, SolutionCacheEntry& entry);
+		void insert(const std::string& key, const SolutionCacheEntry& entry);
+		void clear();
+
+	private:
+		void insertToMemory(const std::string& key, const SolutionCacheEntry& entry);
+		static std::string filePath(const std::string& directory, const std::string& key);
+		static void write(std::ostream& out, const std::string& key, const SolutionCacheEntry& entry);
+		static bool read(std::istream& in, const std::string& key, SolutionCacheEntry& entry);
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "SolveSchedule.h"
+#include "KinematicDiagram.h"
+#include "Joint.h"
+#include "Link.h"
+#include "KinematicUtils.h"
+
+namespace kinematics {
+
+	double LengthRef::get() const {
+		return link->getLengthAt(index1, index2);
+	}
+
+	/**
+	 * Update the position of the joint by the primitive of this step.
+	 */
+	void SolveStep::solve() const {
+		if (type == TYPE_JOINT) {
+			joint->forwardKinematics();
+		}
+		else if (type == TYPE_RIGID) {
+			joint->pos = link->transformByJoints(index1, index2, index);
+		}
+		else if (type == TYPE_DYAD) {
+			glm::dvec2 int1, int2;
+			if (!circleCircleIntersection(joints[0]->pos, lengths[0].get(), joints[1]->pos, lengths[1].get(), int1, int2)) throw "No intersection";
+
+			// choose the intersection that is closer to the previous position
+			if (glm::length(int1 - joint->pos) <= glm::length(int2 - joint->pos)) {
+				joint->pos = int1;
+			}
+			else {
+				joint->pos = int2;
+			}
+		}
+		else if (type == TYPE_SLIDER_DYAD) {
+			joint->pos = circleLineIntersection(joints[1]->pos, lengths[1].get(), joints[0]->pos, joint->pos, joint->pos);
+		}
+		else if (type == TYPE_TRIAD) {
+			glm::dvec2 new_pos;
+			if (!kinematics::threeLengths(joints[0]->pos, lengths[0].get(), joints[1]->pos, lengths[1].get(), joints[2]->pos, lengths[2].get(), lengths[3].get(), lengths[4].get(), lengths[5].get(), joint->pos, joints[3]->pos, joints[4]->pos, new_pos)) throw "No solution";
+
+			joint->pos = new_pos;
+		}
+
+		joint->determined = true;
+	}
+
+	/**
+	 * Compile the schedule for the current determined flags of the diagram.
+	 * The undetermined joints are visited in the same order as the queue of the forward kinematics,
+	 * and each joint records the primitive that it uses once enough of its neighbors are determined.
+	 * The determined flags of the joints are updated as if the steps were solved.
+	 */
+	void SolveSchedule::compile(KinematicDiagram& diagram) {
+		clear();
+
+		// put the joints whose position has not been determined into the queue
+		std::vector<Joint*> queue;
+		for (auto it = diagram.joints.begin(); it != diagram.joints.end(); ++it) {
+			if (!it->second->determined) queue.push_back(it->second.get());
+		}
+
+		int num_failures = 0;
+		for (int i = 0; i < queue.size(); ++i) {
+			SolveStep step;
+			if (queue[i]->plan(step)) {
+				queue[i]->determined = true;
+				steps.push_back(step);
+				num_failures = 0;
+			}
+			else {
+				queue.push_back(queue[i]);
+
+				// none of the remaining joints can be determined
+				if (++num_failures >= queue.size() - i - 1) {
+					clear();
+					throw "infinite loop is detected.";
+				}
+			}
+		}
+	}
+
+	void SolveSchedule::execute() const {
+		for (int i = 0; i < steps.size(); ++i) {
+			steps[i].solve();
+		}
+	}
+
+	void SolveSchedule::clear() {
+		steps.clear();
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace kinematics {
+
+	class Joint;
+	class Link;
+	class KinematicDiagram;
+
+	/**
+	 * The length between joints[index1] and joints[index2] of the link in its original shape.
+	 * It is looked up in the length table of the link when the step is solved,
+	 * so that the schedule stays valid when the shape is changed.
+	 */
+	class LengthRef {
+	public:
+		Link* link;
+		int index1;
+		int index2;
+
+	public:
+		LengthRef() : link(NULL), index1(-1), index2(-1) {}
+		LengthRef(Link* link, int index1, int index2) : link(link), index1(index1), index2(index2) {}
+
+		double get() const;
+	};
+
+	/**
+	 * One operation of the forward kinematics, i.e., the primitive that determines the position of a joint
+	 * and the joints and the lengths it uses.
+	 *  TYPE_FIXED:       the joint has no link, so the position does not change.
+	 *  TYPE_JOINT:       the joint calculates its position by itself (e.g., gear).
+	 *  TYPE_RIGID:       the joint, joints[index] of the link, is transformed with the link by joints[index1] and joints[index2].
+	 *  TYPE_DYAD:        circle-circle intersection around joints[0] and joints[1].
+	 *  TYPE_SLIDER_DYAD: intersection of the circle around joints[1] and the line through joints[0].
+	 *  TYPE_TRIAD:       three lengths from joints[0], joints[1], and joints[2] via the intermediate joints[3] and joints[4].
+	 */
+	class SolveStep {
+	public:
+		static enum { TYPE_FIXED = 0, TYPE_JOINT, TYPE_RIGID, TYPE_DYAD, TYPE_SLIDER_DYAD, TYPE_TRIAD };
+
+	public:
+		int type;
+		Joint* joint;
+		Link* link;
+		int index1;
+		int index2;
+		int index;
+		Joint* joints[5];
+		LengthRef lengths[6];
+
+	public:
+		SolveStep() : type(TYPE_FIXED), joint(NULL), link(NULL), index1(-1), index2(-1), index(-1) {}
+		SolveStep(int type, Joint* joint) : type(type), joint(joint), link(NULL), index1(-1), index2(-1), index(-1) {}
+
+		void solve() const;
+	};
+
+	/**
+	 * The ordered list of the operations that determine the positions of the undetermined joints.
+	 * The schedule is compiled once by propagating the determined flags in the same order as the queue
+	 * in the forward kinematics, and it can be replayed as long as the topology and the determined flags
+	 * at the beginning of the step are the same as when it was compiled.
+	 */
+	class SolveSchedule {
+	public:
+		std::vector<SolveStep> steps;
+
+	public:
+		SolveSchedule() {}
+
+		void compile(KinematicDiagram& diagram);
+		void execute() const;
+		void clear();
+	};
+
+}
\ No newline at end of file
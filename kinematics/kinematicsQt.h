@@ -0,0 +1,5 @@
+#pragma once
+
+#include "kinematics.h"
+#include "kinematics/DiagramPainter.h"
+#include "kinematics/DiagramReader.h"
\ No newline at end of file